@@ -12,6 +12,8 @@
 #include "gdk/gdkprofilerprivate.h"
 
 #include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
+#include <errno.h>
 
 struct _GskGLDevice
 {
@@ -21,6 +23,9 @@ struct _GskGLDevice
   const char *version_string;
   GdkGLAPI api;
 
+  /* Where linked programs for this driver are stored between runs, or NULL */
+  char *program_cache_dir;
+
   guint sampler_ids[GSK_GPU_SAMPLER_N_SAMPLERS];
 };
 
@@ -153,6 +158,8 @@ gsk_gl_device_finalize (GObject *object)
   g_hash_table_unref (self->gl_programs);
   glDeleteSamplers (G_N_ELEMENTS (self->sampler_ids), self->sampler_ids);
 
+  g_free (self->program_cache_dir);
+
   G_OBJECT_CLASS (gsk_gl_device_parent_class)->finalize (object);
 }
 
@@ -230,6 +237,124 @@ gsk_gl_device_setup_samplers (GskGLDevice *self)
     }
 }
 
+/* Directories of other drivers that weren't used for this long are removed */
+#define PROGRAM_CACHE_MAX_AGE (7 * 24 * 60 * 60)
+
+/* Each driver version gets its own subdirectory, which is touched
+ * whenever it is used. Binaries of other drivers can't be loaded
+ * after an update, so remove them once they haven't been used for
+ * a while. Systems with more than one GPU keep theirs, as long as
+ * they are in use.
+ */
+static void
+gsk_gl_device_remove_stale_program_caches (const char *cache_dir,
+                                           const char *driver_hash)
+{
+  const char *name;
+  GDir *dir;
+  gint64 now;
+
+  now = g_get_real_time () / G_USEC_PER_SEC;
+
+  dir = g_dir_open (cache_dir, 0, NULL);
+  if (dir == NULL)
+    return;
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      GStatBuf buf;
+      char *path;
+
+      path = g_build_filename (cache_dir, name, NULL);
+
+      if (g_str_equal (name, driver_hash))
+        {
+          g_utime (path, NULL);
+          g_free (path);
+          continue;
+        }
+
+      if (g_stat (path, &buf) != 0)
+        {
+          g_free (path);
+          continue;
+        }
+
+      if (g_file_test (path, G_FILE_TEST_IS_DIR))
+        {
+          GDir *stale_dir;
+
+          if (now - buf.st_mtime < PROGRAM_CACHE_MAX_AGE)
+            {
+              g_free (path);
+              continue;
+            }
+
+          stale_dir = g_dir_open (path, 0, NULL);
+          if (stale_dir)
+            {
+              const char *stale_name;
+
+              while ((stale_name = g_dir_read_name (stale_dir)))
+                {
+                  char *stale_path = g_build_filename (path, stale_name, NULL);
+                  g_remove (stale_path);
+                  g_free (stale_path);
+                }
+
+              g_dir_close (stale_dir);
+            }
+
+          g_rmdir (path);
+        }
+      else
+        {
+          /* Left over from before binaries were sorted by driver */
+          g_remove (path);
+        }
+
+      g_free (path);
+    }
+
+  g_dir_close (dir);
+}
+
+static void
+gsk_gl_device_setup_program_cache (GskGLDevice  *self,
+                                   GdkGLContext *context)
+{
+  char *driver_string, *driver_hash, *cache_dir;
+  GLint n_formats = 0;
+
+  /* We want to see the shaders get compiled when debugging them */
+  if (GSK_DEBUG_CHECK (SHADERS))
+    return;
+
+  if (!gdk_gl_context_check_version (context, "4.1", "3.0") &&
+      !epoxy_has_gl_extension ("GL_ARB_get_program_binary"))
+    return;
+
+  glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+  if (n_formats <= 0)
+    return;
+
+  driver_string = g_strdup_printf ("%s\n%s\n%s\n%s",
+                                   (const char *) glGetString (GL_VENDOR),
+                                   (const char *) glGetString (GL_RENDERER),
+                                   (const char *) glGetString (GL_VERSION),
+                                   GTK_VERSION);
+  driver_hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, driver_string, -1);
+  cache_dir = g_build_filename (g_get_user_cache_dir (), "gtk-4.0", "gl-program-cache", NULL);
+
+  gsk_gl_device_remove_stale_program_caches (cache_dir, driver_hash);
+
+  self->program_cache_dir = g_build_filename (cache_dir, driver_hash, NULL);
+
+  g_free (cache_dir);
+  g_free (driver_hash);
+  g_free (driver_string);
+}
+
 GskGpuDevice *
 gsk_gl_device_get_for_display (GdkDisplay  *display,
                                GError     **error)
@@ -265,6 +390,7 @@ gsk_gl_device_get_for_display (GdkDisplay  *display,
   self->version_string = gdk_gl_context_get_glsl_version_string (context);
   self->api = gdk_gl_context_get_api (context);
   gsk_gl_device_setup_samplers (self);
+  gsk_gl_device_setup_program_cache (self, context);
 
   g_object_set_data (G_OBJECT (display), "-gsk-gl-device", self);
 
@@ -373,20 +499,19 @@ print_shader_info (const char *prefix,
     }
 }
 
-static GLuint
-gsk_gl_device_load_shader (GskGLDevice       *self,
-                           const char        *program_name,
-                           GLenum             shader_type,
-                           GskGpuColorStates  color_states,
-                           guint32            variation,
-                           GskGpuShaderClip   clip,
-                           guint              n_external_textures,
-                           GError           **error)
+static char *
+gsk_gl_device_get_shader_source (GskGLDevice       *self,
+                                 const char        *program_name,
+                                 GLenum             shader_type,
+                                 GskGpuColorStates  color_states,
+                                 guint32            variation,
+                                 GskGpuShaderClip   clip,
+                                 guint              n_external_textures,
+                                 GError           **error)
 {
   GString *preamble;
   char *resource_name;
   GBytes *bytes;
-  GLuint shader_id;
 
   preamble = g_string_new (NULL);
 
@@ -422,7 +547,7 @@ gsk_gl_device_load_shader (GskGLDevice       *self,
 
       default:
         g_assert_not_reached ();
-        return 0;
+        return NULL;
     }
 
   g_string_append_printf (preamble, "#define GSK_COLOR_STATES %uu\n", color_states);
@@ -448,20 +573,29 @@ gsk_gl_device_load_shader (GskGLDevice       *self,
   bytes = g_resources_lookup_data (resource_name, 0, error);
   g_free (resource_name);
   if (bytes == NULL)
-    return 0;
+    {
+      g_string_free (preamble, TRUE);
+      return NULL;
+    }
 
-  shader_id = glCreateShader (shader_type);
+  g_string_append_len (preamble, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes));
+  g_bytes_unref (bytes);
 
-  glShaderSource (shader_id,
-                  2,
-                  (const char *[]) {
-                    preamble->str,
-                    g_bytes_get_data (bytes, NULL),
-                  },
-                  NULL);
+  return g_string_free (preamble, FALSE);
+}
 
-  g_bytes_unref (bytes);
-  g_string_free (preamble, TRUE);
+static GLuint
+gsk_gl_device_load_shader (GskGLDevice *self,
+                           const char  *program_name,
+                           GLenum       shader_type,
+                           const char  *source,
+                           GError     **error)
+{
+  GLuint shader_id;
+
+  shader_id = glCreateShader (shader_type);
+
+  glShaderSource (shader_id, 1, &source, NULL);
 
   glCompileShader (shader_id);
 
@@ -476,6 +610,107 @@ gsk_gl_device_load_shader (GskGLDevice       *self,
   return shader_id;
 }
 
+/* The cache file is named after the shader sources, so changed
+ * shaders just miss the cache. The driver is taken care of by the
+ * directory.
+ */
+static char *
+gsk_gl_device_get_program_cache_file (GskGLDevice *self,
+                                      const char  *vertex_source,
+                                      const char  *fragment_source)
+{
+  GChecksum *checksum;
+  char *path;
+
+  if (self->program_cache_dir == NULL)
+    return NULL;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_checksum_update (checksum, (const guchar *) vertex_source, -1);
+  g_checksum_update (checksum, (const guchar *) "", 1);
+  g_checksum_update (checksum, (const guchar *) fragment_source, -1);
+
+  path = g_build_filename (self->program_cache_dir, g_checksum_get_string (checksum), NULL);
+
+  g_checksum_free (checksum);
+
+  return path;
+}
+
+static GLuint
+gsk_gl_device_load_program_binary (GskGLDevice *self,
+                                   const char  *cache_file)
+{
+  GError *error = NULL;
+  GLuint program_id;
+  GLint link_status;
+  guint32 format;
+  char *data;
+  gsize size;
+
+  if (!g_file_get_contents (cache_file, &data, &size, &error))
+    {
+      if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        GSK_DEBUG (SHADERS, "Failed to load program binary '%s': %s", cache_file, error->message);
+      g_clear_error (&error);
+      return 0;
+    }
+
+  if (size <= sizeof (guint32))
+    {
+      g_free (data);
+      return 0;
+    }
+
+  memcpy (&format, data, sizeof (guint32));
+
+  program_id = glCreateProgram ();
+  glProgramBinary (program_id, format, data + sizeof (guint32), size - sizeof (guint32));
+  g_free (data);
+
+  /* Drivers reject binaries from other versions, and we recompile */
+  glGetProgramiv (program_id, GL_LINK_STATUS, &link_status);
+  if (link_status == GL_FALSE)
+    {
+      glDeleteProgram (program_id);
+      g_remove (cache_file);
+      return 0;
+    }
+
+  return program_id;
+}
+
+static void
+gsk_gl_device_save_program_binary (GskGLDevice *self,
+                                   GLuint       program_id,
+                                   const char  *cache_file)
+{
+  GError *error = NULL;
+  GLint length = 0;
+  GLenum format;
+  guint32 format32;
+  char *data;
+
+  glGetProgramiv (program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return;
+
+  data = g_malloc (sizeof (guint32) + length);
+  glGetProgramBinary (program_id, length, &length, &format, data + sizeof (guint32));
+  format32 = format;
+  memcpy (data, &format32, sizeof (guint32));
+
+  if (g_mkdir_with_parents (self->program_cache_dir, 0755) != 0 ||
+      !g_file_set_contents (cache_file, data, sizeof (guint32) + length, &error))
+    {
+      GSK_DEBUG (SHADERS, "Failed to save program binary '%s': %s",
+                 cache_file, error ? error->message : g_strerror (errno));
+      g_clear_error (&error);
+    }
+
+  g_free (data);
+}
+
 static GLuint
 gsk_gl_device_load_program (GskGLDevice               *self,
                             const GskGpuShaderOpClass *op_class,
@@ -487,15 +722,48 @@ gsk_gl_device_load_program (GskGLDevice               *self,
 {
   G_GNUC_UNUSED gint64 begin_time = GDK_PROFILER_CURRENT_TIME;
   GLuint vertex_shader_id, fragment_shader_id, program_id;
+  char *vertex_source, *fragment_source, *cache_file;
   GLint link_status;
 
-  vertex_shader_id = gsk_gl_device_load_shader (self, op_class->shader_name, GL_VERTEX_SHADER, color_states, variation, clip, n_external_textures, error);
-  if (vertex_shader_id == 0)
+  vertex_source = gsk_gl_device_get_shader_source (self, op_class->shader_name, GL_VERTEX_SHADER, color_states, variation, clip, n_external_textures, error);
+  if (vertex_source == NULL)
     return 0;
 
-  fragment_shader_id = gsk_gl_device_load_shader (self, op_class->shader_name, GL_FRAGMENT_SHADER, color_states, variation, clip, n_external_textures, error);
+  fragment_source = gsk_gl_device_get_shader_source (self, op_class->shader_name, GL_FRAGMENT_SHADER, color_states, variation, clip, n_external_textures, error);
+  if (fragment_source == NULL)
+    {
+      g_free (vertex_source);
+      return 0;
+    }
+
+  cache_file = gsk_gl_device_get_program_cache_file (self, vertex_source, fragment_source);
+  if (cache_file)
+    {
+      program_id = gsk_gl_device_load_program_binary (self, cache_file);
+      if (program_id)
+        {
+          gdk_profiler_end_markf (begin_time,
+                                  "Load Program Binary",
+                                  "name=%s id=%u",
+                                  op_class->shader_name, program_id);
+          g_free (cache_file);
+          g_free (fragment_source);
+          g_free (vertex_source);
+          return program_id;
+        }
+    }
+
+  vertex_shader_id = gsk_gl_device_load_shader (self, op_class->shader_name, GL_VERTEX_SHADER, vertex_source, error);
+  fragment_shader_id = vertex_shader_id ? gsk_gl_device_load_shader (self, op_class->shader_name, GL_FRAGMENT_SHADER, fragment_source, error) : 0;
+  g_free (fragment_source);
+  g_free (vertex_source);
   if (fragment_shader_id == 0)
-    return 0;
+    {
+      if (vertex_shader_id)
+        glDeleteShader (vertex_shader_id);
+      g_free (cache_file);
+      return 0;
+    }
 
   program_id = glCreateProgram ();
 
@@ -504,6 +772,9 @@ gsk_gl_device_load_program (GskGLDevice               *self,
 
   op_class->setup_attrib_locations (program_id);
 
+  if (cache_file)
+    glProgramParameteri (program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
   glLinkProgram (program_id);
 
   glGetProgramiv (program_id, GL_LINK_STATUS, &link_status);
@@ -536,10 +807,17 @@ gsk_gl_device_load_program (GskGLDevice               *self,
       g_free (buffer);
 
       glDeleteProgram (program_id);
+      g_free (cache_file);
 
       return 0;
     }
 
+  if (cache_file)
+    {
+      gsk_gl_device_save_program_binary (self, program_id, cache_file);
+      g_free (cache_file);
+    }
+
   gdk_profiler_end_markf (begin_time,
                           "Compile Program",
                           "name=%s id=%u frag=%u vert=%u",
@@ -8,24 +8,36 @@
 #include "gskgpuuploadopprivate.h"
 
 #include "gdk/gdkcolorstateprivate.h"
+#include "gdk/gdkmemoryformatprivate.h"
 #include "gdk/gdkprofilerprivate.h"
 #include "gdk/gdktextureprivate.h"
 
 #include "gsk/gskdebugprivate.h"
 #include "gsk/gskprivate.h"
 
-#define MAX_SLICES_PER_ATLAS 64
-
+/* Atlases start out at ATLAS_SIZE. When an atlas fills up while most
+ * of it is still in use, the next one is made twice as big, up to
+ * MAX_ATLAS_SIZE, so that large scales or scripts with many glyphs
+ * don't keep throwing away atlases full of glyphs we still need.
+ * When a full atlas of that size gets collected because most of it
+ * is dead, the size is halved again, and trimming the cache resets
+ * it to ATLAS_SIZE.
+ *
+ * The number of slices and the largest item scale with the atlas.
+ */
 #define ATLAS_SIZE 1024
 
-#define MAX_ATLAS_ITEM_SIZE 256
+#define MAX_ATLAS_SIZE 4096
 
-#define MIN_ALIVE_PIXELS (ATLAS_SIZE * ATLAS_SIZE / 2)
+#define SLICES_PER_ATLAS_SIZE 64
 
-#define ATLAS_TIMEOUT_SCALE 4
+#define MAX_SLICES_PER_ATLAS (SLICES_PER_ATLAS_SIZE * MAX_ATLAS_SIZE / ATLAS_SIZE)
+
+#define MAX_ATLAS_ITEM_SIZE(atlas_size) ((atlas_size) / 4)
 
-G_STATIC_ASSERT (MAX_ATLAS_ITEM_SIZE < ATLAS_SIZE);
-G_STATIC_ASSERT (MIN_ALIVE_PIXELS < ATLAS_SIZE * ATLAS_SIZE);
+#define MIN_ALIVE_PIXELS(atlas_size) ((atlas_size) * (atlas_size) / 2)
+
+#define ATLAS_TIMEOUT_SCALE 4
 
 typedef struct _GskGpuCached GskGpuCached;
 typedef struct _GskGpuCachedClass GskGpuCachedClass;
@@ -44,9 +56,13 @@ struct _GskGpuCache
 
   GHashTable *texture_cache;
   GHashTable *ccs_texture_caches[GDK_COLOR_STATE_N_IDS];
+  GHashTable *scaled_texture_cache;
   GHashTable *glyph_cache;
 
   GskGpuCachedAtlas *current_atlas;
+  gsize atlas_size;
+
+  gint64 last_gc_timestamp;
 
   /* atomic */ gsize dead_texture_pixels;
 };
@@ -176,9 +192,11 @@ struct _GskGpuCachedAtlas
   GskGpuCached parent;
 
   GskGpuImage *image;
+  gsize size;
 
   gsize remaining_pixels;
   gsize n_slices;
+  gsize max_slices;
   struct {
     gsize width;
     gsize height;
@@ -221,7 +239,7 @@ gsk_gpu_cached_atlas_should_collect (GskGpuCache  *cache,
       cached->pixels == 0)
     return TRUE;
 
-  return cached->pixels + self->remaining_pixels < MIN_ALIVE_PIXELS;
+  return cached->pixels + self->remaining_pixels < MIN_ALIVE_PIXELS (self->size);
 }
 
 static const GskGpuCachedClass GSK_GPU_CACHED_ATLAS_CLASS =
@@ -237,8 +255,10 @@ gsk_gpu_cached_atlas_new (GskGpuCache *cache)
   GskGpuCachedAtlas *self;
 
   self = gsk_gpu_cached_new (cache, &GSK_GPU_CACHED_ATLAS_CLASS, NULL);
-  self->image = gsk_gpu_device_create_atlas_image (cache->device, ATLAS_SIZE, ATLAS_SIZE);
+  self->size = cache->atlas_size;
+  self->image = gsk_gpu_device_create_atlas_image (cache->device, self->size, self->size);
   self->remaining_pixels = gsk_gpu_image_get_width (self->image) * gsk_gpu_image_get_height (self->image);
+  self->max_slices = SLICES_PER_ATLAS_SIZE * self->size / ATLAS_SIZE;
 
   return self;
 }
@@ -260,6 +280,7 @@ struct _GskGpuCachedTexture
   GdkTexture *texture;
   GskGpuImage *image;
   GdkColorState *color_state;  /* no ref because global. May be NULL */
+  gboolean scaled;             /* image is a downscaled, mipmapped copy */
 };
 
 static GHashTable *
@@ -285,6 +306,16 @@ gsk_gpu_cache_get_texture_hash_table (GskGpuCache   *cache,
     }
 }
 
+static GHashTable *
+gsk_gpu_cached_texture_get_hash_table (GskGpuCache         *cache,
+                                       GskGpuCachedTexture *self)
+{
+  if (self->scaled)
+    return cache->scaled_texture_cache;
+
+  return gsk_gpu_cache_get_texture_hash_table (cache, self->color_state);
+}
+
 static void
 gsk_gpu_cached_texture_free (GskGpuCache  *cache,
                              GskGpuCached *cached)
@@ -295,7 +326,7 @@ gsk_gpu_cached_texture_free (GskGpuCache  *cache,
 
   g_clear_object (&self->image);
 
-  texture_cache = gsk_gpu_cache_get_texture_hash_table (cache, self->color_state);
+  texture_cache = gsk_gpu_cached_texture_get_hash_table (cache, self);
 
   if (g_hash_table_steal_extended (texture_cache, self->texture, &key, &value))
     {
@@ -362,13 +393,17 @@ static GskGpuCachedTexture *
 gsk_gpu_cached_texture_new (GskGpuCache   *cache,
                             GdkTexture    *texture,
                             GskGpuImage   *image,
-                            GdkColorState *color_state)
+                            GdkColorState *color_state,
+                            gboolean       scaled)
 {
   GskGpuCachedTexture *self;
   GHashTable *texture_cache;
 
-  /* First, move any existing renderdata */
-  self = gdk_texture_get_render_data (texture, cache);
+  /* First, move any existing renderdata.
+   * Scaled copies never use the renderdata, so lookups for the
+   * texture itself keep their fast path.
+   */
+  self = scaled ? NULL : gdk_texture_get_render_data (texture, cache);
   if (self)
     {
       gdk_texture_steal_render_data (texture);
@@ -382,15 +417,16 @@ gsk_gpu_cached_texture_new (GskGpuCache   *cache,
   self->texture = texture;
   self->image = g_object_ref (image);
   self->color_state = color_state;
+  self->scaled = scaled;
   ((GskGpuCached *)self)->pixels = gsk_gpu_image_get_width (image) * gsk_gpu_image_get_height (image);
   self->dead_pixels_counter = &cache->dead_texture_pixels;
   self->use_count = 2;
 
-  if (!gdk_texture_set_render_data (texture, cache, self, gsk_gpu_cached_texture_destroy_cb))
+  if (scaled || !gdk_texture_set_render_data (texture, cache, self, gsk_gpu_cached_texture_destroy_cb))
     {
       g_object_weak_ref (G_OBJECT (texture), (GWeakNotify) gsk_gpu_cached_texture_destroy_cb, self);
 
-      texture_cache = gsk_gpu_cache_get_texture_hash_table (cache, self->color_state);
+      texture_cache = gsk_gpu_cached_texture_get_hash_table (cache, self);
       g_assert (texture_cache != NULL);
       g_hash_table_insert (texture_cache, texture, self);
     }
@@ -481,6 +517,39 @@ static const GskGpuCachedClass GSK_GPU_CACHED_GLYPH_CLASS =
 /* }}} */
 /* {{{ GskGpuCache */
 
+static gsize
+gsk_gpu_image_get_memory_size (GskGpuImage *image)
+{
+  gsize size;
+
+  if (image == NULL)
+    return 0;
+
+  size = gsk_gpu_image_get_width (image) *
+         gsk_gpu_image_get_height (image) *
+         gdk_memory_format_bytes_per_pixel (gsk_gpu_image_get_format (image));
+
+  /* The smaller levels of a mip chain add up to a third of the image */
+  if (gsk_gpu_image_get_flags (image) & GSK_GPU_IMAGE_MIPMAP)
+    size += size / 3;
+
+  return size;
+}
+
+/* Glyphs on an atlas don't count, the atlas does */
+static gsize
+gsk_gpu_cached_get_memory_size (GskGpuCached *cached)
+{
+  if (cached->class == &GSK_GPU_CACHED_TEXTURE_CLASS)
+    return gsk_gpu_image_get_memory_size (((GskGpuCachedTexture *) cached)->image);
+  else if (cached->class == &GSK_GPU_CACHED_ATLAS_CLASS)
+    return gsk_gpu_image_get_memory_size (((GskGpuCachedAtlas *) cached)->image);
+  else if (cached->class == &GSK_GPU_CACHED_GLYPH_CLASS && cached->atlas == NULL)
+    return gsk_gpu_image_get_memory_size (((GskGpuCachedGlyph *) cached)->image);
+  else
+    return 0;
+}
+
 static void
 print_cache_stats (GskGpuCache *self)
 {
@@ -489,6 +558,9 @@ print_cache_stats (GskGpuCache *self)
   guint stale_glyphs = 0;
   guint textures = 0;
   guint atlases = 0;
+  gsize glyph_bytes = 0;
+  gsize texture_bytes = 0;
+  gsize atlas_bytes = 0;
   GString *ratios = g_string_new ("");
 
   for (cached = self->first_cached; cached != NULL; cached = cached->next)
@@ -498,18 +570,21 @@ print_cache_stats (GskGpuCache *self)
           glyphs++;
           if (cached->stale)
             stale_glyphs++;
+          glyph_bytes += gsk_gpu_cached_get_memory_size (cached);
         }
       else if (cached->class == &GSK_GPU_CACHED_TEXTURE_CLASS)
         {
           textures++;
+          texture_bytes += gsk_gpu_cached_get_memory_size (cached);
         }
       else if (cached->class == &GSK_GPU_CACHED_ATLAS_CLASS)
         {
           double ratio;
 
           atlases++;
+          atlas_bytes += gsk_gpu_cached_get_memory_size (cached);
 
-          ratio = (double) cached->pixels / (double) (ATLAS_SIZE * ATLAS_SIZE);
+          ratio = (double) cached->pixels / (double) (((GskGpuCachedAtlas *) cached)->size * ((GskGpuCachedAtlas *) cached)->size);
 
           if (ratios->len == 0)
             g_string_append (ratios, " (ratios ");
@@ -523,26 +598,122 @@ print_cache_stats (GskGpuCache *self)
     g_string_append (ratios, ")");
 
   gdk_debug_message ("Cached items\n"
-                     "  glyphs:   %5u (%u stale)\n"
-                     "  textures: %5u (%u in hash)\n"
-                     "  atlases:  %5u%s",
-                     glyphs, stale_glyphs,
-                     textures, g_hash_table_size (self->texture_cache),
-                     atlases, ratios->str);
+                     "  glyphs:   %5u (%u stale, %" G_GSIZE_FORMAT " kB outside atlases)\n"
+                     "  textures: %5u (%u in hash, %" G_GSIZE_FORMAT " kB)\n"
+                     "  atlases:  %5u (%" G_GSIZE_FORMAT " kB)%s",
+                     glyphs, stale_glyphs, glyph_bytes / 1024,
+                     textures, g_hash_table_size (self->texture_cache), texture_bytes / 1024,
+                     atlases, atlas_bytes / 1024, ratios->str);
 
   g_string_free (ratios, TRUE);
 }
 
+static int
+compare_cached_timestamp (gconstpointer a,
+                          gconstpointer b)
+{
+  const GskGpuCached *cached_a = *(const GskGpuCached **) a;
+  const GskGpuCached *cached_b = *(const GskGpuCached **) b;
+
+  if (cached_a->timestamp < cached_b->timestamp)
+    return -1;
+  else if (cached_a->timestamp > cached_b->timestamp)
+    return 1;
+  else
+    return 0;
+}
+
+/* Frees the least recently used items until the images held by the
+ * cache fit into max_bytes. Atlases are freed as a whole, with their
+ * glyphs, and the atlas currently being filled is kept.
+ *
+ * Items used since the last GC are kept, too. They are still being
+ * drawn, so freeing them would only get them uploaded again in the
+ * next frame, and again after every GC if the working set does not
+ * fit into the budget.
+ */
+static void
+gsk_gpu_cache_trim (GskGpuCache *self,
+                    gsize        max_bytes)
+{
+  GskGpuCached *cached;
+  GPtrArray *candidates;
+  gsize n_bytes = 0;
+  guint i;
+
+  candidates = g_ptr_array_new ();
+
+  for (cached = self->first_cached; cached != NULL; cached = cached->next)
+    {
+      gsize size = gsk_gpu_cached_get_memory_size (cached);
+
+      if (size == 0)
+        continue;
+
+      n_bytes += size;
+      if (cached != (GskGpuCached *) self->current_atlas &&
+          cached->timestamp < self->last_gc_timestamp)
+        g_ptr_array_add (candidates, cached);
+    }
+
+  if (n_bytes > max_bytes)
+    {
+      GSK_DEBUG (CACHE, "Cache uses %" G_GSIZE_FORMAT " kB, trimming to %" G_GSIZE_FORMAT " kB",
+                 n_bytes / 1024, max_bytes / 1024);
+
+      g_ptr_array_sort (candidates, compare_cached_timestamp);
+
+      for (i = 0; i < candidates->len && n_bytes > max_bytes; i++)
+        {
+          cached = g_ptr_array_index (candidates, i);
+          n_bytes -= gsk_gpu_cached_get_memory_size (cached);
+          gsk_gpu_cached_free (self, cached);
+        }
+
+      if (n_bytes > max_bytes)
+        GSK_DEBUG (CACHE, "Items in use need %" G_GSIZE_FORMAT " kB, keeping them", n_bytes / 1024);
+
+      /* We are short on memory, don't make it worse with big atlases */
+      if (self->atlas_size > ATLAS_SIZE)
+        {
+          self->atlas_size = MIN (ATLAS_SIZE, gsk_gpu_device_get_max_image_size (self->device));
+          GSK_DEBUG (CACHE, "Shrinking atlases to %" G_GSIZE_FORMAT "x%" G_GSIZE_FORMAT, self->atlas_size, self->atlas_size);
+        }
+    }
+
+  g_ptr_array_unref (candidates);
+}
+
+/* A full atlas of the current size was mostly dead by the time
+ * it got collected, so the glyphs in use fit into smaller ones.
+ */
+static void
+gsk_gpu_cache_atlas_collected (GskGpuCache       *self,
+                               GskGpuCachedAtlas *atlas)
+{
+  if (atlas == self->current_atlas ||
+      atlas->size != self->atlas_size ||
+      self->atlas_size <= ATLAS_SIZE)
+    return;
+
+  self->atlas_size /= 2;
+  GSK_DEBUG (CACHE, "Shrinking atlases to %" G_GSIZE_FORMAT "x%" G_GSIZE_FORMAT, self->atlas_size, self->atlas_size);
+}
+
 /* Returns TRUE if everything was GC'ed */
 gboolean
 gsk_gpu_cache_gc (GskGpuCache *self,
                   gint64       cache_timeout,
+                  gsize        max_bytes,
                   gint64       timestamp)
 {
   GskGpuCached *cached, *prev;
   gint64 before G_GNUC_UNUSED = GDK_PROFILER_CURRENT_TIME;
   gboolean is_empty = TRUE;
 
+  gsk_gpu_cache_trim (self, max_bytes);
+  self->last_gc_timestamp = timestamp;
+
   /* We walk the cache from the end so we don't end up with prev
    * being a leftover glyph on the atlas we are freeing
    */
@@ -550,7 +721,11 @@ gsk_gpu_cache_gc (GskGpuCache *self,
     {
       prev = cached->prev;
       if (gsk_gpu_cached_should_collect (self, cached, cache_timeout, timestamp))
-        gsk_gpu_cached_free (self, cached);
+        {
+          if (cached->class == &GSK_GPU_CACHED_ATLAS_CLASS)
+            gsk_gpu_cache_atlas_collected (self, (GskGpuCachedAtlas *) cached);
+          gsk_gpu_cached_free (self, cached);
+        }
       else
         is_empty &= cached->stale;
     }
@@ -601,6 +776,7 @@ gsk_gpu_cache_dispose (GObject *object)
   gsk_gpu_cache_clear_cache (self);
   g_hash_table_unref (self->glyph_cache);
   g_hash_table_unref (self->texture_cache);
+  g_hash_table_unref (self->scaled_texture_cache);
 
   G_OBJECT_CLASS (gsk_gpu_cache_parent_class)->dispose (object);
 }
@@ -631,6 +807,8 @@ gsk_gpu_cache_init (GskGpuCache *self)
                                         gsk_gpu_cached_glyph_equal);
   self->texture_cache = g_hash_table_new (g_direct_hash,
                                           g_direct_equal);
+  self->scaled_texture_cache = g_hash_table_new (g_direct_hash,
+                                                 g_direct_equal);
 }
 
 /* This rounds up to the next number that has <= 2 bits set:
@@ -663,7 +841,7 @@ gsk_gpu_cached_atlas_allocate (GskGpuCachedAtlas *atlas,
 
   best_y = 0;
   best_slice = G_MAXSIZE;
-  can_add_slice = atlas->n_slices < MAX_SLICES_PER_ATLAS;
+  can_add_slice = atlas->n_slices < atlas->max_slices;
   if (can_add_slice)
     waste = height; /* Require less than 100% waste */
   else
@@ -671,7 +849,7 @@ gsk_gpu_cached_atlas_allocate (GskGpuCachedAtlas *atlas,
 
   for (i = 0, y = 0; i < atlas->n_slices; y += atlas->slices[i].height, i++)
     {
-      if (atlas->slices[i].height < height || ATLAS_SIZE - atlas->slices[i].width < width)
+      if (atlas->slices[i].height < height || atlas->size - atlas->slices[i].width < width)
         continue;
 
       slice_waste = atlas->slices[i].height - height;
@@ -693,12 +871,12 @@ gsk_gpu_cached_atlas_allocate (GskGpuCachedAtlas *atlas,
         return FALSE;
 
       slice_height = round_up_atlas_size (MAX (height, 4));
-      if (slice_height > ATLAS_SIZE - y)
+      if (slice_height > atlas->size - y)
         return FALSE;
 
       atlas->n_slices++;
-      if (atlas->n_slices == MAX_SLICES_PER_ATLAS)
-        slice_height = ATLAS_SIZE - y;
+      if (atlas->n_slices == atlas->max_slices)
+        slice_height = atlas->size - y;
 
       atlas->slices[i].width = 0;
       atlas->slices[i].height = slice_height;
@@ -710,7 +888,7 @@ gsk_gpu_cached_atlas_allocate (GskGpuCachedAtlas *atlas,
   *out_y = best_y;
 
   atlas->slices[best_slice].width += width;
-  g_assert (atlas->slices[best_slice].width <= ATLAS_SIZE);
+  g_assert (atlas->slices[best_slice].width <= atlas->size);
 
   atlas->remaining_pixels -= width * height;
   ((GskGpuCached *) atlas)->pixels += width * height;
@@ -726,7 +904,22 @@ gsk_gpu_cache_ensure_atlas (GskGpuCache *self,
     return;
 
   if (self->current_atlas)
-    self->current_atlas->remaining_pixels = 0;
+    {
+      GskGpuCachedAtlas *atlas = self->current_atlas;
+
+      /* The atlas filled up with glyphs that are still in use,
+       * so we'll likely need more room than it had.
+       */
+      if (((GskGpuCached *) atlas)->pixels >= MIN_ALIVE_PIXELS (atlas->size) &&
+          self->atlas_size == atlas->size &&
+          self->atlas_size * 2 <= MIN (MAX_ATLAS_SIZE, gsk_gpu_device_get_max_image_size (self->device)))
+        {
+          self->atlas_size *= 2;
+          GSK_DEBUG (CACHE, "Growing atlases to %" G_GSIZE_FORMAT "x%" G_GSIZE_FORMAT, self->atlas_size, self->atlas_size);
+        }
+
+      atlas->remaining_pixels = 0;
+    }
 
   self->current_atlas = gsk_gpu_cached_atlas_new (self);
 }
@@ -747,7 +940,7 @@ gsk_gpu_cache_add_atlas_image (GskGpuCache      *self,
                                gsize            *out_x,
                                gsize            *out_y)
 {
-  if (width > MAX_ATLAS_ITEM_SIZE || height > MAX_ATLAS_ITEM_SIZE)
+  if (width > MAX_ATLAS_ITEM_SIZE (self->atlas_size) || height > MAX_ATLAS_ITEM_SIZE (self->atlas_size))
     return NULL;
 
   gsk_gpu_cache_ensure_atlas (self, FALSE);
@@ -805,7 +998,56 @@ gsk_gpu_cache_cache_texture_image (GskGpuCache   *self,
 {
   GskGpuCachedTexture *cache;
 
-  cache = gsk_gpu_cached_texture_new (self, texture, image, color_state);
+  cache = gsk_gpu_cached_texture_new (self, texture, image, color_state, FALSE);
+  g_return_if_fail (cache != NULL);
+
+  gsk_gpu_cached_use (self, (GskGpuCached *) cache, timestamp);
+}
+
+/*
+ * gsk_gpu_cache_lookup_scaled_texture_image:
+ * @self: a `GskGpuCache`
+ * @texture: the texture
+ * @timestamp: the timestamp of the frame
+ * @color_state: the color state the image must be in
+ *
+ * Looks up a downscaled and mipmapped copy of @texture that was
+ * stored with gsk_gpu_cache_cache_scaled_texture_image().
+ *
+ * Callers must check that the image is big enough for their needs.
+ *
+ * Returns: (transfer full) (nullable): the image
+ **/
+GskGpuImage *
+gsk_gpu_cache_lookup_scaled_texture_image (GskGpuCache   *self,
+                                           GdkTexture    *texture,
+                                           gint64         timestamp,
+                                           GdkColorState *color_state)
+{
+  GskGpuCachedTexture *cache;
+
+  cache = g_hash_table_lookup (self->scaled_texture_cache, texture);
+
+  if (!cache || !cache->image ||
+      cache->color_state != color_state ||
+      gsk_gpu_cached_texture_is_invalid (cache))
+    return NULL;
+
+  gsk_gpu_cached_use (self, (GskGpuCached *) cache, timestamp);
+
+  return g_object_ref (cache->image);
+}
+
+void
+gsk_gpu_cache_cache_scaled_texture_image (GskGpuCache   *self,
+                                          GdkTexture    *texture,
+                                          gint64         timestamp,
+                                          GskGpuImage   *image,
+                                          GdkColorState *color_state)
+{
+  GskGpuCachedTexture *cache;
+
+  cache = gsk_gpu_cached_texture_new (self, texture, image, color_state, TRUE);
   g_return_if_fail (cache != NULL);
 
   gsk_gpu_cached_use (self, (GskGpuCached *) cache, timestamp);
@@ -840,7 +1082,12 @@ gsk_gpu_cache_lookup_glyph_image (GskGpuCache            *self,
   cache = g_hash_table_lookup (self->glyph_cache, &lookup);
   if (cache)
     {
-      gsk_gpu_cached_use (self, (GskGpuCached *) cache, gsk_gpu_frame_get_timestamp (frame));
+      gint64 timestamp = gsk_gpu_frame_get_timestamp (frame);
+
+      gsk_gpu_cached_use (self, (GskGpuCached *) cache, timestamp);
+      /* Keep the atlas from looking unused to gsk_gpu_cache_trim() */
+      if (((GskGpuCached *) cache)->atlas)
+        gsk_gpu_cached_use (self, (GskGpuCached *) ((GskGpuCached *) cache)->atlas, timestamp);
 
       *out_bounds = cache->bounds;
       *out_origin = cache->origin;
@@ -927,6 +1174,7 @@ gsk_gpu_cache_new (GskGpuDevice *device)
 
   self = g_object_new (GSK_TYPE_GPU_CACHE, NULL);
   self->device = g_object_ref (device);
+  self->atlas_size = MIN (ATLAS_SIZE, gsk_gpu_device_get_max_image_size (device));
 
   return self;
 }
@@ -26,6 +26,7 @@ GskGpuCache *           gsk_gpu_cache_new                               (GskGpuD
 
 gboolean                gsk_gpu_cache_gc                                (GskGpuCache            *self,
                                                                          gint64                  cache_timeout,
+                                                                         gsize                   max_bytes,
                                                                          gint64                  timestamp);
 gsize                   gsk_gpu_cache_get_dead_texture_pixels           (GskGpuCache            *self);
 GskGpuImage *           gsk_gpu_cache_get_atlas_image                   (GskGpuCache            *self);
@@ -39,6 +40,15 @@ void                    gsk_gpu_cache_cache_texture_image               (GskGpuC
                                                                          gint64                  timestamp,
                                                                          GskGpuImage            *image,
                                                                          GdkColorState          *color_state);
+GskGpuImage *           gsk_gpu_cache_lookup_scaled_texture_image       (GskGpuCache            *self,
+                                                                         GdkTexture             *texture,
+                                                                         gint64                  timestamp,
+                                                                         GdkColorState          *color_state);
+void                    gsk_gpu_cache_cache_scaled_texture_image        (GskGpuCache            *self,
+                                                                         GdkTexture             *texture,
+                                                                         gint64                  timestamp,
+                                                                         GskGpuImage            *image,
+                                                                         GdkColorState          *color_state);
 
 typedef enum
 {
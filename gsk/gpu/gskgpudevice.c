@@ -16,6 +16,8 @@
 
 #define CACHE_TIMEOUT 15  /* seconds */
 
+#define CACHE_BUDGET 256  /* megabytes */
+
 typedef struct _GskGpuDevicePrivate GskGpuDevicePrivate;
 
 struct _GskGpuDevicePrivate
@@ -26,6 +28,10 @@ struct _GskGpuDevicePrivate
   GskGpuCache *cache; /* we don't own a ref, but manage the cache */
   guint cache_gc_source;
   int cache_timeout;  /* in seconds, or -1 to disable gc */
+  gsize cache_budget; /* in bytes */
+
+  GMemoryMonitor *memory_monitor;
+  gulong low_memory_handler;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GskGpuDevice, gsk_gpu_device, G_TYPE_OBJECT)
@@ -33,6 +39,7 @@ G_DEFINE_TYPE_WITH_PRIVATE (GskGpuDevice, gsk_gpu_device, G_TYPE_OBJECT)
 /* Returns TRUE if everything was GC'ed */
 static gboolean
 gsk_gpu_device_gc (GskGpuDevice *self,
+                   gsize         budget,
                    gint64        timestamp)
 {
   GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
@@ -46,6 +53,7 @@ gsk_gpu_device_gc (GskGpuDevice *self,
 
   result = gsk_gpu_cache_gc (priv->cache,
                              priv->cache_timeout >= 0 ? priv->cache_timeout * G_TIME_SPAN_SECOND : -1,
+                             budget,
                              timestamp);
   if (result)
     g_clear_object (&priv->cache);
@@ -65,7 +73,7 @@ cache_gc_cb (gpointer data)
   timestamp = g_get_monotonic_time ();
   GSK_DEBUG (CACHE, "Periodic GC (timestamp %lld)", (long long) timestamp);
 
-  if (gsk_gpu_device_gc (self, timestamp))
+  if (gsk_gpu_device_gc (self, priv->cache_budget, timestamp))
     {
       priv->cache_gc_source = 0;
       return G_SOURCE_REMOVE;
@@ -91,10 +99,36 @@ gsk_gpu_device_maybe_gc (GskGpuDevice *self)
   if (priv->cache_timeout == 0 || dead_texture_pixels > 1000000)
     {
       GSK_DEBUG (CACHE, "Pre-frame GC (%" G_GSIZE_FORMAT " dead pixels)", dead_texture_pixels);
-      gsk_gpu_device_gc (self, g_get_monotonic_time ());
+      gsk_gpu_device_gc (self, priv->cache_budget, g_get_monotonic_time ());
     }
 }
 
+static void
+low_memory_warning_cb (GMemoryMonitor             *monitor,
+                       GMemoryMonitorWarningLevel  level,
+                       GskGpuDevice               *self)
+{
+  GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
+  gsize budget;
+
+  if (priv->cache_timeout < 0)
+    return;
+
+  /* Give back half the budget at first, and everything we can
+   * once the system is about to start killing processes.
+   */
+  if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL)
+    budget = 0;
+  else if (level >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM)
+    budget = priv->cache_budget / 4;
+  else
+    budget = priv->cache_budget / 2;
+
+  GSK_DEBUG (CACHE, "Low memory GC (level %d)", level);
+
+  gsk_gpu_device_gc (self, budget, g_get_monotonic_time ());
+}
+
 void
 gsk_gpu_device_queue_gc (GskGpuDevice *self)
 {
@@ -111,6 +145,8 @@ gsk_gpu_device_dispose (GObject *object)
   GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
 
   g_clear_handle_id (&priv->cache_gc_source, g_source_remove);
+  g_clear_signal_handler (&priv->low_memory_handler, priv->memory_monitor);
+  g_clear_object (&priv->memory_monitor);
 
   G_OBJECT_CLASS (gsk_gpu_device_parent_class)->dispose (object);
 }
@@ -150,6 +186,7 @@ gsk_gpu_device_setup (GskGpuDevice *self,
   priv->display = g_object_ref (display);
   priv->max_image_size = max_image_size;
   priv->cache_timeout = CACHE_TIMEOUT;
+  priv->cache_budget = (gsize) CACHE_BUDGET * 1024 * 1024;
 
   str = g_getenv ("GSK_CACHE_TIMEOUT");
   if (str != NULL)
@@ -168,6 +205,29 @@ gsk_gpu_device_setup (GskGpuDevice *self,
         }
     }
 
+  str = g_getenv ("GSK_CACHE_BUDGET");
+  if (str != NULL)
+    {
+      guint64 value;
+      GError *error = NULL;
+
+      if (!g_ascii_string_to_unsigned (str, 10, 0, G_MAXSIZE / (1024 * 1024), &value, &error))
+        {
+          g_warning ("Failed to parse GSK_CACHE_BUDGET: %s", error->message);
+          g_error_free (error);
+        }
+      else
+        {
+          priv->cache_budget = (gsize) value * 1024 * 1024;
+        }
+    }
+
+  priv->memory_monitor = g_memory_monitor_dup_default ();
+  priv->low_memory_handler = g_signal_connect (priv->memory_monitor,
+                                               "low-memory-warning",
+                                               G_CALLBACK (low_memory_warning_cb),
+                                               self);
+
   if (GSK_DEBUG_CHECK (CACHE))
     {
       if (priv->cache_timeout < 0)
@@ -176,6 +236,8 @@ gsk_gpu_device_setup (GskGpuDevice *self,
         gdk_debug_message ("Cache GC before every frame");
       else
         gdk_debug_message ("Cache GC timeout: %d seconds", priv->cache_timeout);
+
+      gdk_debug_message ("Cache budget: %" G_GSIZE_FORMAT " MB", priv->cache_budget / (1024 * 1024));
     }
 }
 
@@ -10,6 +10,7 @@
 #include "gskgpunodeprocessorprivate.h"
 #include "gskgpuopprivate.h"
 #include "gskgpurendererprivate.h"
+#include "gskgpushaderopprivate.h"
 #include "gskgpuuploadopprivate.h"
 
 #include "gskdebugprivate.h"
@@ -48,6 +49,12 @@ struct _GskGpuFramePrivate
   GskGpuBuffer *storage_buffer;
   guchar *storage_buffer_data;
   gsize storage_buffer_used;
+
+  /* glyph uploads that haven't been handed to the workers yet */
+  gpointer glyph_batch;
+
+  /* for GSK_DEBUG=verbose */
+  gsize n_culled_glyphs;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GskGpuFrame, gsk_gpu_frame, G_TYPE_OBJECT)
@@ -64,6 +71,9 @@ gsk_gpu_frame_default_cleanup (GskGpuFrame *self)
   GskGpuOp *op;
   gsize i;
 
+  /* The ops own the batch */
+  priv->glyph_batch = NULL;
+
   for (i = 0; i < gsk_gpu_ops_get_size (&priv->ops); i += op->op_class->size)
     {
       op = (GskGpuOp *) gsk_gpu_ops_index (&priv->ops, i);
@@ -73,6 +83,7 @@ gsk_gpu_frame_default_cleanup (GskGpuFrame *self)
   gsk_gpu_ops_set_size (&priv->ops, 0);
 
   priv->last_op = NULL;
+  priv->n_culled_glyphs = 0;
 }
 
 static void
@@ -113,8 +124,12 @@ gsk_gpu_frame_finalize (GObject *object)
 
   gsk_gpu_ops_clear (&priv->ops);
 
-  g_clear_object (&priv->vertex_buffer);
-  g_clear_object (&priv->storage_buffer);
+  /* dispose waited for the GPU, so the buffers are idle and the
+   * next frame can reuse them instead of allocating new ones */
+  if (priv->vertex_buffer)
+    gsk_gpu_renderer_recycle_vertex_buffer (priv->renderer, g_steal_pointer (&priv->vertex_buffer));
+  if (priv->storage_buffer)
+    gsk_gpu_renderer_recycle_storage_buffer (priv->renderer, g_steal_pointer (&priv->storage_buffer));
 
   g_object_unref (priv->device);
 
@@ -182,6 +197,32 @@ gsk_gpu_frame_get_timestamp (GskGpuFrame *self)
   return priv->timestamp;
 }
 
+void
+gsk_gpu_frame_add_culled_glyphs (GskGpuFrame *self,
+                                 gsize        n_glyphs)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+
+  priv->n_culled_glyphs += n_glyphs;
+}
+
+gpointer
+gsk_gpu_frame_get_glyph_batch (GskGpuFrame *self)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+
+  return priv->glyph_batch;
+}
+
+void
+gsk_gpu_frame_set_glyph_batch (GskGpuFrame *self,
+                               gpointer     batch)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+
+  priv->glyph_batch = batch;
+}
+
 gboolean
 gsk_gpu_frame_should_optimize (GskGpuFrame         *self,
                                GskGpuOptimizations  optimization)
@@ -200,6 +241,9 @@ gsk_gpu_frame_verbose_print (GskGpuFrame *self,
   if (GSK_RENDERER_DEBUG_CHECK (GSK_RENDERER (priv->renderer), VERBOSE))
     {
       GskGpuOp *op;
+      GskGpuShaderOp *merge_op = NULL;
+      gsize n_instances = 0, n_shader_ops = 0, n_draws = 0, n_merged = 0, n_uploads = 0;
+      gsize max_ops_per_draw = gsk_gpu_shader_op_get_max_ops_per_draw (self);
       guint indent = 1;
       GString *string = g_string_new (heading);
       g_string_append (string, ":\n");
@@ -211,7 +255,47 @@ gsk_gpu_frame_verbose_print (GskGpuFrame *self,
           gsk_gpu_op_print (op, self, string, indent);
           if (op->op_class->stage == GSK_GPU_STAGE_BEGIN_PASS)
             indent++;
+
+          if (op->op_class->stage == GSK_GPU_STAGE_UPLOAD)
+            n_uploads++;
+
+          if (op->op_class->stage == GSK_GPU_STAGE_SHADER)
+            {
+              GskGpuShaderOp *shader = (GskGpuShaderOp *) op;
+
+              n_shader_ops++;
+              n_instances += shader->n_ops;
+
+              /* mirrors the merging done by the backends */
+              if (merge_op && gsk_gpu_shader_op_can_merge (merge_op, op, n_merged))
+                {
+                  n_merged += shader->n_ops;
+                }
+              else
+                {
+                  n_draws += (n_merged + max_ops_per_draw - 1) / max_ops_per_draw;
+                  merge_op = shader;
+                  n_merged = shader->n_ops;
+                }
+            }
+          else
+            {
+              n_draws += (n_merged + max_ops_per_draw - 1) / max_ops_per_draw;
+              merge_op = NULL;
+              n_merged = 0;
+            }
         }
+      n_draws += (n_merged + max_ops_per_draw - 1) / max_ops_per_draw;
+
+      if (n_shader_ops > 0)
+        g_string_append_printf (string,
+                                "%" G_GSIZE_FORMAT " shader instances in %" G_GSIZE_FORMAT " ops, "
+                                "%" G_GSIZE_FORMAT " draws after merging\n",
+                                n_instances, n_shader_ops, n_draws);
+      if (n_uploads > 0)
+        g_string_append_printf (string, "%" G_GSIZE_FORMAT " uploads\n", n_uploads);
+      if (priv->n_culled_glyphs > 0)
+        g_string_append_printf (string, "%" G_GSIZE_FORMAT " clipped glyphs skipped\n", priv->n_culled_glyphs);
 
       gdk_debug_message ("%s", string->str);
       g_string_free (string, TRUE);
@@ -401,6 +485,15 @@ gsk_gpu_frame_get_last_op (GskGpuFrame *self)
   return priv->last_op;
 }
 
+/* Uploads the texture for use in this frame only */
+GskGpuImage *
+gsk_gpu_frame_upload_texture_uncached (GskGpuFrame  *self,
+                                       gboolean      with_mipmap,
+                                       GdkTexture   *texture)
+{
+  return GSK_GPU_FRAME_GET_CLASS (self)->upload_texture (self, with_mipmap, texture);
+}
+
 GskGpuImage *
 gsk_gpu_frame_upload_texture (GskGpuFrame  *self,
                               gboolean      with_mipmap,
@@ -409,7 +502,7 @@ gsk_gpu_frame_upload_texture (GskGpuFrame  *self,
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
   GskGpuImage *image;
 
-  image = GSK_GPU_FRAME_GET_CLASS (self)->upload_texture (self, with_mipmap, texture);
+  image = gsk_gpu_frame_upload_texture_uncached (self, with_mipmap, texture);
 
   if (image)
     gsk_gpu_cache_cache_texture_image (gsk_gpu_device_get_cache (priv->device), texture, priv->timestamp, image, NULL);
@@ -451,7 +544,11 @@ gsk_gpu_frame_reserve_vertex_data (GskGpuFrame *self,
   gsize size_needed;
 
   if (priv->vertex_buffer == NULL)
-    priv->vertex_buffer = gsk_gpu_frame_create_vertex_buffer (self, DEFAULT_VERTEX_BUFFER_SIZE);
+    {
+      priv->vertex_buffer = gsk_gpu_renderer_steal_vertex_buffer (priv->renderer);
+      if (priv->vertex_buffer == NULL)
+        priv->vertex_buffer = gsk_gpu_frame_create_vertex_buffer (self, DEFAULT_VERTEX_BUFFER_SIZE);
+    }
 
   size_needed = round_up (priv->vertex_buffer_used, size) + size;
 
@@ -497,7 +594,11 @@ gsk_gpu_frame_ensure_storage_buffer (GskGpuFrame *self)
     return;
 
   if (priv->storage_buffer == NULL)
-    priv->storage_buffer = gsk_gpu_frame_create_storage_buffer (self, DEFAULT_STORAGE_BUFFER_SIZE);
+    {
+      priv->storage_buffer = gsk_gpu_renderer_steal_storage_buffer (priv->renderer);
+      if (priv->storage_buffer == NULL)
+        priv->storage_buffer = gsk_gpu_frame_create_storage_buffer (self, DEFAULT_STORAGE_BUFFER_SIZE);
+    }
 
   priv->storage_buffer_data = gsk_gpu_buffer_map (priv->storage_buffer);
 }
@@ -609,6 +710,7 @@ gsk_gpu_frame_submit (GskGpuFrame *self)
 {
   GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
 
+  gsk_gpu_upload_glyph_ops_flush (self);
   gsk_gpu_frame_seal_ops (self);
   gsk_gpu_frame_verbose_print (self, "start of frame");
   gsk_gpu_frame_sort_ops (self);
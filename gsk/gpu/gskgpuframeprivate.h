@@ -53,12 +53,20 @@ GskGpuDevice *          gsk_gpu_frame_get_device                        (GskGpuF
 gint64                  gsk_gpu_frame_get_timestamp                     (GskGpuFrame            *self) G_GNUC_PURE;
 gboolean                gsk_gpu_frame_should_optimize                   (GskGpuFrame            *self,
                                                                          GskGpuOptimizations     optimization) G_GNUC_PURE;
+void                    gsk_gpu_frame_add_culled_glyphs                 (GskGpuFrame            *self,
+                                                                         gsize                   n_glyphs);
+gpointer                gsk_gpu_frame_get_glyph_batch                   (GskGpuFrame            *self);
+void                    gsk_gpu_frame_set_glyph_batch                   (GskGpuFrame            *self,
+                                                                         gpointer                batch);
 
 gpointer                gsk_gpu_frame_alloc_op                          (GskGpuFrame            *self,
                                                                          gsize                   size);
 GskGpuImage *           gsk_gpu_frame_upload_texture                    (GskGpuFrame            *self,
                                                                          gboolean                with_mipmap,
                                                                          GdkTexture             *texture);
+GskGpuImage *           gsk_gpu_frame_upload_texture_uncached           (GskGpuFrame            *self,
+                                                                         gboolean                with_mipmap,
+                                                                         GdkTexture             *texture);
 GskGpuDescriptors *     gsk_gpu_frame_create_descriptors                (GskGpuFrame            *self);
 gsize                   gsk_gpu_frame_reserve_vertex_data               (GskGpuFrame            *self,
                                                                          gsize                   size);
@@ -765,12 +765,246 @@ gsk_gpu_node_processor_get_node_as_image (GskGpuNodeProcessor   *self,
                                     out_bounds);
 }
 
+/* The blur shader takes one sample per pixel of blur radius, so large
+ * blurs get expensive quickly. Blurs are run at a lower resolution
+ * instead, as long as the radius stays at least this many pixels.
+ * That keeps blurs of common sizes, like shadows, at full resolution
+ * and only downscales those of 32 pixels or more.
+ */
+#define MIN_DOWNSCALED_BLUR_RADIUS 16
+#define MAX_BLUR_DOWNSCALE 8
+
+static guint
+gsk_gpu_node_processor_get_blur_downscale (GskGpuNodeProcessor *self,
+                                           float                blur_radius)
+{
+  float radius;
+  guint downscale;
+
+  if (!gsk_gpu_frame_should_optimize (self->frame, GSK_GPU_OPTIMIZE_BLUR))
+    return 1;
+
+  radius = blur_radius * MIN (graphene_vec2_get_x (&self->scale),
+                              graphene_vec2_get_y (&self->scale));
+
+  downscale = 1;
+  while (downscale < MAX_BLUR_DOWNSCALE &&
+         radius / (2 * downscale) >= MIN_DOWNSCALED_BLUR_RADIUS)
+    downscale *= 2;
+
+  return downscale;
+}
+
+/* Halves the resolution of the source until it is at 1/downscale of
+ * the pixel scale. Linear sampling at the center of every 2x2 block
+ * averages it, so each step is a box filter and the blur doesn't pick
+ * up aliasing from skipping source pixels.
+ */
+static GskGpuImage *
+gsk_gpu_node_processor_reduce_blur_source (GskGpuNodeProcessor   *self,
+                                           guint                  downscale,
+                                           GskGpuImage           *source_image,
+                                           GdkMemoryDepth         source_depth,
+                                           const graphene_rect_t *source_rect,
+                                           graphene_rect_t       *out_rect)
+{
+  GskGpuNodeProcessor other;
+  GskGpuImage *image, *reduced;
+  graphene_rect_t image_rect, reduced_rect;
+  graphene_vec2_t scale;
+  guint i;
+
+  image = g_object_ref (source_image);
+  image_rect = *source_rect;
+
+  for (i = 2; i <= downscale; i *= 2)
+    {
+      graphene_vec2_init (&scale,
+                          graphene_vec2_get_x (&self->scale) / i,
+                          graphene_vec2_get_y (&self->scale) / i);
+      rect_round_to_pixels (&image_rect, &scale, &self->offset, &reduced_rect);
+
+      reduced = gsk_gpu_node_processor_init_draw (&other,
+                                                  self->frame,
+                                                  self->ccs,
+                                                  source_depth,
+                                                  &scale,
+                                                  &reduced_rect);
+      if (reduced == NULL)
+        {
+          g_object_unref (image);
+          return NULL;
+        }
+
+      gsk_gpu_node_processor_sync_globals (&other, 0);
+
+      gsk_gpu_node_processor_image_op (&other,
+                                       image,
+                                       self->ccs,
+                                       GSK_GPU_SAMPLER_DEFAULT,
+                                       &image_rect,
+                                       &image_rect);
+
+      gsk_gpu_node_processor_finish_draw (&other, reduced);
+
+      g_object_unref (image);
+      image = reduced;
+      image_rect = reduced_rect;
+    }
+
+  *out_rect = image_rect;
+  return image;
+}
+
+/* Does both blur passes into offscreens at 1/downscale of the
+ * resolution, and then scales the result up into the target.
+ * Gaussian blurs with radii this large remove all the detail that
+ * the lower resolution loses, once the source has been filtered
+ * down to that resolution.
+ */
+static void
+gsk_gpu_node_processor_downscaled_blur_op (GskGpuNodeProcessor       *self,
+                                           guint                      downscale,
+                                           const graphene_rect_t     *rect,
+                                           const graphene_point_t    *shadow_offset,
+                                           float                      blur_radius,
+                                           const GdkRGBA             *shadow_color,
+                                           GskGpuImage               *source_image,
+                                           GdkMemoryDepth             source_depth,
+                                           const graphene_rect_t     *source_rect)
+{
+  GskGpuNodeProcessor other;
+  GskGpuImage *reduced, *intermediate, *blurred;
+  guint32 reduced_descriptor, intermediate_descriptor;
+  graphene_vec2_t direction, scale;
+  graphene_rect_t clip_rect, reduced_rect, intermediate_rect, blurred_rect, draw_rect;
+  float clip_radius;
+
+  clip_radius = gsk_cairo_blur_compute_pixels (blur_radius / 2.0);
+  graphene_vec2_init (&scale,
+                      graphene_vec2_get_x (&self->scale) / downscale,
+                      graphene_vec2_get_y (&self->scale) / downscale);
+
+  gsk_gpu_node_processor_get_clip_bounds (self, &clip_rect);
+  clip_rect.origin.x -= shadow_offset->x;
+  clip_rect.origin.y -= shadow_offset->y;
+  if (!gsk_rect_intersection (rect, &clip_rect, &blurred_rect))
+    return;
+  rect_round_to_pixels (&blurred_rect, &scale, &self->offset, &blurred_rect);
+
+  graphene_rect_inset (&clip_rect, 0.f, -clip_radius);
+  if (!gsk_rect_intersection (rect, &clip_rect, &intermediate_rect))
+    return;
+  rect_round_to_pixels (&intermediate_rect, &scale, &self->offset, &intermediate_rect);
+
+  reduced = gsk_gpu_node_processor_reduce_blur_source (self,
+                                                       downscale,
+                                                       source_image,
+                                                       source_depth,
+                                                       source_rect,
+                                                       &reduced_rect);
+  if (reduced == NULL)
+    return;
+
+  /* horizontal pass, from the reduced source */
+  intermediate = gsk_gpu_node_processor_init_draw (&other,
+                                                   self->frame,
+                                                   self->ccs,
+                                                   source_depth,
+                                                   &scale,
+                                                   &intermediate_rect);
+  if (intermediate == NULL)
+    {
+      g_object_unref (reduced);
+      return;
+    }
+
+  gsk_gpu_node_processor_sync_globals (&other, 0);
+
+  graphene_vec2_init (&direction, blur_radius, 0.0f);
+  reduced_descriptor = gsk_gpu_node_processor_add_image (&other, reduced, GSK_GPU_SAMPLER_TRANSPARENT);
+  gsk_gpu_blur_op (other.frame,
+                   gsk_gpu_clip_get_shader_clip (&other.clip, &other.offset, &intermediate_rect),
+                   gsk_gpu_node_processor_color_states_self (&other),
+                   other.desc,
+                   reduced_descriptor,
+                   &intermediate_rect,
+                   &other.offset,
+                   &reduced_rect,
+                   &direction);
+
+  gsk_gpu_node_processor_finish_draw (&other, intermediate);
+  g_object_unref (reduced);
+
+  /* vertical pass, still at the lower resolution */
+  blurred = gsk_gpu_node_processor_init_draw (&other,
+                                              self->frame,
+                                              self->ccs,
+                                              source_depth,
+                                              &scale,
+                                              &blurred_rect);
+  if (blurred == NULL)
+    {
+      g_object_unref (intermediate);
+      return;
+    }
+
+  gsk_gpu_node_processor_sync_globals (&other, 0);
+
+  graphene_vec2_init (&direction, 0.0f, blur_radius);
+  intermediate_descriptor = gsk_gpu_node_processor_add_image (&other, intermediate, GSK_GPU_SAMPLER_TRANSPARENT);
+  if (shadow_color)
+    {
+      gsk_gpu_blur_shadow_op (other.frame,
+                              gsk_gpu_clip_get_shader_clip (&other.clip, &other.offset, &blurred_rect),
+                              gsk_gpu_node_processor_color_states_for_rgba (&other),
+                              other.desc,
+                              intermediate_descriptor,
+                              &blurred_rect,
+                              &other.offset,
+                              &intermediate_rect,
+                              &direction,
+                              GSK_RGBA_TO_VEC4 (shadow_color));
+    }
+  else
+    {
+      gsk_gpu_blur_op (other.frame,
+                       gsk_gpu_clip_get_shader_clip (&other.clip, &other.offset, &blurred_rect),
+                       gsk_gpu_node_processor_color_states_self (&other),
+                       other.desc,
+                       intermediate_descriptor,
+                       &blurred_rect,
+                       &other.offset,
+                       &intermediate_rect,
+                       &direction);
+    }
+
+  gsk_gpu_node_processor_finish_draw (&other, blurred);
+
+  /* and scale it up, without drawing outside of rect */
+  if (gsk_rect_intersection (rect, &blurred_rect, &draw_rect))
+    {
+      graphene_rect_offset (&draw_rect, shadow_offset->x, shadow_offset->y);
+      graphene_rect_offset (&blurred_rect, shadow_offset->x, shadow_offset->y);
+      gsk_gpu_node_processor_image_op (self,
+                                       blurred,
+                                       self->ccs,
+                                       GSK_GPU_SAMPLER_DEFAULT,
+                                       &draw_rect,
+                                       &blurred_rect);
+    }
+
+  g_object_unref (blurred);
+  g_object_unref (intermediate);
+}
+
 static void
 gsk_gpu_node_processor_blur_op (GskGpuNodeProcessor       *self,
                                 const graphene_rect_t     *rect,
                                 const graphene_point_t    *shadow_offset,
                                 float                      blur_radius,
                                 const GdkRGBA             *shadow_color,
+                                GskGpuImage               *source_image,
                                 GskGpuDescriptors         *source_desc,
                                 guint32                    source_descriptor,
                                 GdkMemoryDepth             source_depth,
@@ -783,6 +1017,22 @@ gsk_gpu_node_processor_blur_op (GskGpuNodeProcessor       *self,
   graphene_rect_t clip_rect, intermediate_rect;
   graphene_point_t real_offset;
   float clip_radius;
+  guint downscale;
+
+  downscale = gsk_gpu_node_processor_get_blur_downscale (self, blur_radius);
+  if (downscale > 1)
+    {
+      gsk_gpu_node_processor_downscaled_blur_op (self,
+                                                 downscale,
+                                                 rect,
+                                                 shadow_offset,
+                                                 blur_radius,
+                                                 shadow_color,
+                                                 source_image,
+                                                 source_depth,
+                                                 source_rect);
+      return;
+    }
 
   clip_radius = gsk_cairo_blur_compute_pixels (blur_radius / 2.0);
 
@@ -1686,11 +1936,12 @@ texture_node_should_mipmap (GskRenderNode         *node,
 }
 
 static GskGpuImage *
-gsk_gpu_lookup_texture (GskGpuFrame    *frame,
-                        GdkColorState  *ccs,
-                        GdkTexture     *texture,
-                        gboolean        try_mipmap,
-                        GdkColorState **out_image_cs)
+gsk_gpu_lookup_texture_full (GskGpuFrame    *frame,
+                             GdkColorState  *ccs,
+                             GdkTexture     *texture,
+                             gboolean        try_mipmap,
+                             gboolean        cache_upload,
+                             GdkColorState **out_image_cs)
 {
   GskGpuCache *cache;
   GdkColorState *image_cs;
@@ -1709,7 +1960,12 @@ gsk_gpu_lookup_texture (GskGpuFrame    *frame,
 
   image = gsk_gpu_cache_lookup_texture_image (cache, texture, timestamp, NULL);
   if (image == NULL)
-    image = gsk_gpu_frame_upload_texture (frame, try_mipmap, texture);
+    {
+      if (cache_upload)
+        image = gsk_gpu_frame_upload_texture (frame, try_mipmap, texture);
+      else
+        image = gsk_gpu_frame_upload_texture_uncached (frame, try_mipmap, texture);
+    }
 
   /* Happens ie for oversized textures */
   if (image == NULL)
@@ -1727,6 +1983,158 @@ gsk_gpu_lookup_texture (GskGpuFrame    *frame,
   return image;
 }
 
+static GskGpuImage *
+gsk_gpu_lookup_texture (GskGpuFrame    *frame,
+                        GdkColorState  *ccs,
+                        GdkTexture     *texture,
+                        gboolean        try_mipmap,
+                        GdkColorState **out_image_cs)
+{
+  return gsk_gpu_lookup_texture_full (frame, ccs, texture, try_mipmap, TRUE, out_image_cs);
+}
+
+/* Textures smaller than this are always mipmapped at full size */
+#define SCALED_TEXTURE_MIN_PIXELS (1024 * 1024)
+
+/*
+ * gsk_gpu_node_processor_get_scaled_texture:
+ * @self: a node processor
+ * @texture: a texture that should be mipmapped
+ * @bounds: the bounds the texture is drawn to
+ *
+ * Huge textures that are drawn much smaller than their size, like
+ * photos in a thumbnail grid, waste a lot of memory when they are
+ * cached at full size with all their mipmaps. Instead, this renders
+ * a downscaled copy that is still at least twice the drawn size,
+ * mipmaps it and caches it in place of the full size image.
+ *
+ * The texture is uploaded at full size without mipmaps and without
+ * being cached, so it is freed with the frame. The copy is made by
+ * halving the size repeatedly. Linear sampling at the center of every
+ * 2x2 block averages it, so every step is a box filter.
+ *
+ * Returns: (nullable): a mipmapped image in the compositing color
+ *   state or NULL if the texture should be drawn at full size
+ **/
+static GskGpuImage *
+gsk_gpu_node_processor_get_scaled_texture (GskGpuNodeProcessor   *self,
+                                           GdkTexture            *texture,
+                                           const graphene_rect_t *bounds)
+{
+  GskGpuNodeProcessor other;
+  GskGpuCache *cache;
+  GskGpuImage *image, *scaled;
+  GdkColorState *image_cs;
+  GdkMemoryDepth depth;
+  graphene_rect_t rect;
+  float min_width, min_height;
+  gsize width, height;
+  guint i, n_steps;
+
+  width = gdk_texture_get_width (texture);
+  height = gdk_texture_get_height (texture);
+  if (width * height < SCALED_TEXTURE_MIN_PIXELS)
+    return NULL;
+
+  min_width = bounds->size.width * graphene_vec2_get_x (&self->scale);
+  min_height = bounds->size.height * graphene_vec2_get_y (&self->scale);
+
+  cache = gsk_gpu_device_get_cache (gsk_gpu_frame_get_device (self->frame));
+  image = gsk_gpu_cache_lookup_scaled_texture_image (cache,
+                                                     texture,
+                                                     gsk_gpu_frame_get_timestamp (self->frame),
+                                                     self->ccs);
+  if (image)
+    {
+      if (gsk_gpu_image_get_width (image) >= min_width &&
+          gsk_gpu_image_get_height (image) >= min_height)
+        return image;
+
+      g_object_unref (image);
+    }
+
+  n_steps = 0;
+  while (width > 1 && height > 1 &&
+         width >= 4 * min_width && height >= 4 * min_height)
+    {
+      width = (width + 1) / 2;
+      height = (height + 1) / 2;
+      n_steps++;
+    }
+  if (n_steps == 0)
+    return NULL;
+
+  image = gsk_gpu_lookup_texture_full (self->frame, self->ccs, texture, FALSE, FALSE, &image_cs);
+  if (image == NULL)
+    return NULL;
+
+  depth = gdk_memory_format_get_depth (gsk_gpu_image_get_format (image),
+                                       gsk_gpu_image_get_flags (image) & GSK_GPU_IMAGE_SRGB);
+  rect = GRAPHENE_RECT_INIT (0, 0, gdk_texture_get_width (texture), gdk_texture_get_height (texture));
+  width = gdk_texture_get_width (texture);
+  height = gdk_texture_get_height (texture);
+
+  for (i = 0; i < n_steps; i++)
+    {
+      width = (width + 1) / 2;
+      height = (height + 1) / 2;
+
+      /* Only the copy we keep needs mipmaps */
+      scaled = gsk_gpu_device_create_offscreen_image (gsk_gpu_frame_get_device (self->frame),
+                                                      i + 1 == n_steps,
+                                                      depth,
+                                                      width, height);
+      if (scaled == NULL)
+        {
+          g_object_unref (image);
+          return NULL;
+        }
+
+      gsk_gpu_node_processor_init (&other,
+                                   self->frame,
+                                   scaled,
+                                   self->ccs,
+                                   NULL,
+                                   &(cairo_rectangle_int_t) { 0, 0, width, height },
+                                   &rect);
+
+      gsk_gpu_render_pass_begin_op (other.frame,
+                                    scaled,
+                                    &(cairo_rectangle_int_t) { 0, 0, width, height },
+                                    &GDK_RGBA_TRANSPARENT,
+                                    GSK_RENDER_PASS_OFFSCREEN);
+
+      gsk_gpu_node_processor_sync_globals (&other, 0);
+
+      gsk_gpu_node_processor_image_op (&other,
+                                       image,
+                                       image_cs,
+                                       GSK_GPU_SAMPLER_DEFAULT,
+                                       &rect,
+                                       &rect);
+
+      gsk_gpu_render_pass_end_op (other.frame,
+                                  scaled,
+                                  GSK_RENDER_PASS_OFFSCREEN);
+
+      gsk_gpu_node_processor_finish (&other);
+
+      g_object_unref (image);
+      image = scaled;
+      image_cs = self->ccs;
+    }
+
+  gsk_gpu_mipmap_op (self->frame, image);
+
+  gsk_gpu_cache_cache_scaled_texture_image (cache,
+                                            texture,
+                                            gsk_gpu_frame_get_timestamp (self->frame),
+                                            image,
+                                            self->ccs);
+
+  return image;
+}
+
 static void
 gsk_gpu_node_processor_add_texture_node (GskGpuNodeProcessor *self,
                                          GskRenderNode       *node)
@@ -1739,6 +2147,22 @@ gsk_gpu_node_processor_add_texture_node (GskGpuNodeProcessor *self,
   texture = gsk_texture_node_get_texture (node);
   should_mipmap = texture_node_should_mipmap (node, self->frame, &self->scale);
 
+  if (should_mipmap)
+    {
+      image = gsk_gpu_node_processor_get_scaled_texture (self, texture, &node->bounds);
+      if (image)
+        {
+          gsk_gpu_node_processor_image_op (self,
+                                           image,
+                                           self->ccs,
+                                           GSK_GPU_SAMPLER_MIPMAP_DEFAULT,
+                                           &node->bounds,
+                                           &node->bounds);
+          g_object_unref (image);
+          return;
+        }
+    }
+
   image = gsk_gpu_lookup_texture (self->frame, self->ccs, texture, should_mipmap, &image_cs);
 
   if (image == NULL)
@@ -1876,6 +2300,27 @@ gsk_gpu_node_processor_add_texture_scale_node (GskGpuNodeProcessor *self,
   scaling_filter = gsk_texture_scale_node_get_filter (node);
   need_mipmap = scaling_filter == GSK_SCALING_FILTER_TRILINEAR;
 
+  /* Only trilinear filtering can use a downscaled copy, the other
+   * filters promise to sample the texture's own pixels.
+   */
+  if (need_mipmap)
+    {
+      image = gsk_gpu_node_processor_get_scaled_texture (self, texture, &node->bounds);
+      if (image)
+        {
+          descriptor = gsk_gpu_node_processor_add_image (self, image, GSK_GPU_SAMPLER_MIPMAP_DEFAULT);
+          gsk_gpu_texture_op (self->frame,
+                              gsk_gpu_clip_get_shader_clip (&self->clip, &self->offset, &node->bounds),
+                              self->desc,
+                              descriptor,
+                              &node->bounds,
+                              &self->offset,
+                              &node->bounds);
+          g_object_unref (image);
+          return;
+        }
+    }
+
   image = gsk_gpu_lookup_texture (self->frame, self->ccs, texture, need_mipmap, &image_cs);
 
   if (image == NULL)
@@ -2294,6 +2739,7 @@ gsk_gpu_node_processor_add_blur_node (GskGpuNodeProcessor *self,
                                   graphene_point_zero (),
                                   blur_radius,
                                   NULL,
+                                  image,
                                   self->desc,
                                   descriptor,
                                   gdk_memory_format_get_depth (gsk_gpu_image_get_format (image),
@@ -2360,6 +2806,7 @@ gsk_gpu_node_processor_add_shadow_node (GskGpuNodeProcessor *self,
                                           &GRAPHENE_POINT_INIT (shadow->dx, shadow->dy),
                                           shadow->radius,
                                           &shadow->color,
+                                          image,
                                           desc,
                                           descriptor,
                                           gdk_memory_format_get_depth (gsk_gpu_image_get_format (image),
@@ -2626,6 +3073,8 @@ gsk_gpu_node_processor_add_glyph_node (GskGpuNodeProcessor *self,
   unsigned int flags_mask;
   GskGpuImage *last_image;
   guint32 descriptor;
+  gboolean cull_glyphs;
+  gsize n_culled;
   const float inv_pango_scale = 1.f / PANGO_SCALE;
 
   if (self->opacity < 1.0 &&
@@ -2664,6 +3113,13 @@ gsk_gpu_node_processor_add_glyph_node (GskGpuNodeProcessor *self,
   inv_align_scale_x = 1 / align_scale_x;
   inv_align_scale_y = 1 / align_scale_y;
 
+  /* Long runs of text are often mostly clipped away, think of long
+   * lines in a scrolled text view. Don't look up, rasterize or emit
+   * ops for glyphs nobody will see then.
+   */
+  cull_glyphs = !gsk_gpu_clip_contains_rect (&self->clip, &self->offset, &node->bounds);
+  n_culled = 0;
+
   last_image = NULL;
   descriptor = 0;
   for (i = 0; i < num_glyphs; i++)
@@ -2676,6 +3132,28 @@ gsk_gpu_node_processor_add_glyph_node (GskGpuNodeProcessor *self,
       glyph_origin = GRAPHENE_POINT_INIT (offset.x + glyphs[i].geometry.x_offset * inv_pango_scale,
                                           offset.y + glyphs[i].geometry.y_offset * inv_pango_scale);
 
+      if (cull_glyphs)
+        {
+          PangoRectangle ink_rect;
+          graphene_rect_t ink_bounds;
+
+          /* The font's ink extents are cheap compared to a cache lookup,
+           * and might save rasterizing the glyph. Grow them a bit to
+           * account for the position rounding below.
+           */
+          pango_font_get_glyph_extents (font, glyphs[i].glyph, &ink_rect, NULL);
+          ink_bounds = GRAPHENE_RECT_INIT (ink_rect.x * inv_pango_scale - 1,
+                                           ink_rect.y * inv_pango_scale - 1,
+                                           ink_rect.width * inv_pango_scale + 2,
+                                           ink_rect.height * inv_pango_scale + 2);
+          if (!gsk_gpu_clip_may_intersect_rect (&self->clip, &glyph_origin, &ink_bounds))
+            {
+              offset.x += glyphs[i].geometry.width * inv_pango_scale;
+              n_culled++;
+              continue;
+            }
+        }
+
       glyph_origin.x = floorf (glyph_origin.x * align_scale_x + 0.5f);
       glyph_origin.y = floorf (glyph_origin.y * align_scale_y + 0.5f);
       flags = (((int) glyph_origin.x & 3) | (((int) glyph_origin.y & 3) << 2)) & flags_mask;
@@ -2729,6 +3207,9 @@ gsk_gpu_node_processor_add_glyph_node (GskGpuNodeProcessor *self,
 
       offset.x += glyphs[i].geometry.width * inv_pango_scale;
     }
+
+  if (n_culled > 0)
+    gsk_gpu_frame_add_culled_glyphs (self->frame, n_culled);
 }
 
 static void
@@ -3237,6 +3718,33 @@ gsk_gpu_get_subsurface_node_as_image (GskGpuFrame            *frame,
                                     out_bounds);
 }
 
+/* Returns the index of the last child that covers the whole clip
+ * with opaque pixels. Everything drawn before it would be overdrawn.
+ */
+static gsize
+gsk_gpu_node_processor_get_first_visible_child (GskGpuNodeProcessor *self,
+                                                GskRenderNode       *node)
+{
+  graphene_rect_t opaque, clip_bounds;
+  gsize i;
+
+  if (!gsk_gpu_frame_should_optimize (self->frame, GSK_GPU_OPTIMIZE_OCCLUSION_CULLING) ||
+      self->blend != GSK_GPU_BLEND_OVER ||
+      self->opacity < 1.0)
+    return 0;
+
+  gsk_gpu_node_processor_get_clip_bounds (self, &clip_bounds);
+
+  for (i = gsk_container_node_get_n_children (node); i-- > 1; )
+    {
+      if (gsk_render_node_get_opaque_rect (gsk_container_node_get_child (node, i), &opaque) &&
+          gsk_rect_contains_rect (&opaque, &clip_bounds))
+        return i;
+    }
+
+  return 0;
+}
+
 static void
 gsk_gpu_node_processor_add_container_node (GskGpuNodeProcessor *self,
                                            GskRenderNode       *node)
@@ -3249,7 +3757,9 @@ gsk_gpu_node_processor_add_container_node (GskGpuNodeProcessor *self,
       return;
     }
 
-  for (i = 0; i < gsk_container_node_get_n_children (node); i++)
+  for (i = gsk_gpu_node_processor_get_first_visible_child (self, node);
+       i < gsk_container_node_get_n_children (node);
+       i++)
     gsk_gpu_node_processor_add_node (self, gsk_container_node_get_child (node, i));
 }
 
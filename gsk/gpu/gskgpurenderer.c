@@ -3,6 +3,7 @@
 #include "gskgpurendererprivate.h"
 
 #include "gskdebugprivate.h"
+#include "gskgpubufferprivate.h"
 #include "gskgpudeviceprivate.h"
 #include "gskgpuframeprivate.h"
 #include "gskprivate.h"
@@ -32,6 +33,7 @@ static const GdkDebugKey gsk_gpu_optimization_keys[] = {
   { "mipmap",    GSK_GPU_OPTIMIZE_MIPMAP,            "Avoid creating mipmaps" },
   { "to-image",  GSK_GPU_OPTIMIZE_TO_IMAGE,          "Don't fast-path creation of images for nodes" },
   { "occlusion", GSK_GPU_OPTIMIZE_OCCLUSION_CULLING, "Disable occlusion culling via opaque node tracking" },
+  { "blur",      GSK_GPU_OPTIMIZE_BLUR,              "Don't blur at reduced resolution for large radii" },
 };
 
 typedef struct _GskGpuRendererPrivate GskGpuRendererPrivate;
@@ -43,6 +45,10 @@ struct _GskGpuRendererPrivate
   GskGpuOptimizations optimizations;
 
   GskGpuFrame *frames[GSK_GPU_MAX_FRAMES];
+
+  /* buffers of finalized frames, handed to the next new frame */
+  GskGpuBuffer *spare_vertex_buffer;
+  GskGpuBuffer *spare_storage_buffer;
 };
 
 static void     gsk_gpu_renderer_dmabuf_downloader_init         (GdkDmabufDownloaderInterface   *iface);
@@ -242,6 +248,9 @@ gsk_gpu_renderer_unrealize (GskRenderer *renderer)
       g_clear_object (&priv->frames[i]);
     }
 
+  g_clear_object (&priv->spare_vertex_buffer);
+  g_clear_object (&priv->spare_storage_buffer);
+
   g_clear_object (&priv->context);
   g_clear_object (&priv->device);
 }
@@ -506,3 +515,71 @@ gsk_gpu_renderer_get_scale (GskGpuRenderer *self)
 {
   return GSK_GPU_RENDERER_GET_CLASS (self)->get_scale (self);
 }
+
+static void
+gsk_gpu_renderer_recycle_buffer (GskGpuBuffer **spare,
+                                 GskGpuBuffer  *buffer)
+{
+  /* Keep the biggest one, frames have to grow small ones anyway */
+  if (*spare == NULL ||
+      gsk_gpu_buffer_get_size (*spare) < gsk_gpu_buffer_get_size (buffer))
+    {
+      g_clear_object (spare);
+      *spare = buffer;
+    }
+  else
+    {
+      g_object_unref (buffer);
+    }
+}
+
+/*
+ * gsk_gpu_renderer_steal_vertex_buffer:
+ * @self: a `GskGpuRenderer`
+ *
+ * Gets a vertex buffer that a previous frame is done with, so
+ * that new frames don't need to allocate and map a new one.
+ *
+ * Returns: (transfer full) (nullable): an idle vertex buffer
+ **/
+GskGpuBuffer *
+gsk_gpu_renderer_steal_vertex_buffer (GskGpuRenderer *self)
+{
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+
+  return g_steal_pointer (&priv->spare_vertex_buffer);
+}
+
+/*
+ * gsk_gpu_renderer_recycle_vertex_buffer:
+ * @self: a `GskGpuRenderer`
+ * @buffer: (transfer full): a vertex buffer the GPU is done with
+ *
+ * Gives a vertex buffer of a finalized frame back to the renderer
+ * for use by the next frame.
+ **/
+void
+gsk_gpu_renderer_recycle_vertex_buffer (GskGpuRenderer *self,
+                                        GskGpuBuffer   *buffer)
+{
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+
+  gsk_gpu_renderer_recycle_buffer (&priv->spare_vertex_buffer, buffer);
+}
+
+GskGpuBuffer *
+gsk_gpu_renderer_steal_storage_buffer (GskGpuRenderer *self)
+{
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+
+  return g_steal_pointer (&priv->spare_storage_buffer);
+}
+
+void
+gsk_gpu_renderer_recycle_storage_buffer (GskGpuRenderer *self,
+                                         GskGpuBuffer   *buffer)
+{
+  GskGpuRendererPrivate *priv = gsk_gpu_renderer_get_instance_private (self);
+
+  gsk_gpu_renderer_recycle_buffer (&priv->spare_storage_buffer, buffer);
+}
@@ -44,5 +44,12 @@ GdkDrawContext *        gsk_gpu_renderer_get_context                    (GskGpuR
 GskGpuDevice *          gsk_gpu_renderer_get_device                     (GskGpuRenderer         *self);
 double                  gsk_gpu_renderer_get_scale                      (GskGpuRenderer         *self);
 
+GskGpuBuffer *          gsk_gpu_renderer_steal_vertex_buffer            (GskGpuRenderer         *self);
+void                    gsk_gpu_renderer_recycle_vertex_buffer          (GskGpuRenderer         *self,
+                                                                         GskGpuBuffer           *buffer);
+GskGpuBuffer *          gsk_gpu_renderer_steal_storage_buffer           (GskGpuRenderer         *self);
+void                    gsk_gpu_renderer_recycle_storage_buffer         (GskGpuRenderer         *self,
+                                                                         GskGpuBuffer           *buffer);
+
 G_END_DECLS
 
@@ -60,6 +60,59 @@ gsk_gpu_shader_op_print (GskGpuOp    *op,
     }
 }
 
+/*
+ * gsk_gpu_shader_op_can_merge:
+ * @self: a shader op
+ * @next: the op following @self and the ops merged with it
+ * @n_ops: number of instances of @self and the ops merged with it
+ *
+ * Checks if @next can be drawn in the same draw call as @self.
+ *
+ * Returns: TRUE if @next can be merged
+ **/
+gboolean
+gsk_gpu_shader_op_can_merge (const GskGpuShaderOp *self,
+                             const GskGpuOp       *next,
+                             gsize                 n_ops)
+{
+  const GskGpuShaderOpClass *shader_op_class = (const GskGpuShaderOpClass *) self->parent_op.op_class;
+  /* careful: We're casting without checking, but the if() does the check */
+  const GskGpuShaderOp *next_shader = (const GskGpuShaderOp *) next;
+
+  return next->op_class == self->parent_op.op_class &&
+         next_shader->desc == self->desc &&
+         next_shader->color_states == self->color_states &&
+         next_shader->variation == self->variation &&
+         next_shader->clip == self->clip &&
+         next_shader->vertex_offset == self->vertex_offset + n_ops * shader_op_class->vertex_size;
+}
+
+/*
+ * gsk_gpu_shader_op_get_max_ops_per_draw:
+ * @frame: the frame to draw
+ *
+ * Gets the number of merged instances the backend of @frame draws
+ * with a single call.
+ *
+ * Returns: the maximum number of instances per draw call
+ **/
+gsize
+gsk_gpu_shader_op_get_max_ops_per_draw (GskGpuFrame *frame)
+{
+  if (!gsk_gpu_frame_should_optimize (frame, GSK_GPU_OPTIMIZE_MERGE))
+    return 1;
+
+#ifdef GDK_RENDERING_VULKAN
+  /* Merged ops may use different images, which needs nonuniform indexing */
+  if (GSK_IS_VULKAN_DEVICE (gsk_gpu_frame_get_device (frame)) &&
+      !gsk_vulkan_device_has_feature (GSK_VULKAN_DEVICE (gsk_gpu_frame_get_device (frame)),
+                                      GDK_VULKAN_FEATURE_NONUNIFORM_INDEXING))
+    return 1;
+#endif
+
+  return MAX_MERGE_OPS;
+}
+
 #ifdef GDK_RENDERING_VULKAN
 GskGpuOp *
 gsk_gpu_shader_op_vk_command_n (GskGpuOp              *op,
@@ -73,12 +126,7 @@ gsk_gpu_shader_op_vk_command_n (GskGpuOp              *op,
   GskGpuOp *next;
   gsize i, n_ops, max_ops_per_draw;
 
-  if (gsk_gpu_frame_should_optimize (frame, GSK_GPU_OPTIMIZE_MERGE) &&
-      gsk_vulkan_device_has_feature (GSK_VULKAN_DEVICE (gsk_gpu_frame_get_device (frame)),
-                                     GDK_VULKAN_FEATURE_NONUNIFORM_INDEXING))
-    max_ops_per_draw = MAX_MERGE_OPS;
-  else
-    max_ops_per_draw = 1;
+  max_ops_per_draw = gsk_gpu_shader_op_get_max_ops_per_draw (frame);
 
   desc = GSK_VULKAN_DESCRIPTORS (self->desc);
   if (desc && state->desc != desc)
@@ -90,17 +138,10 @@ gsk_gpu_shader_op_vk_command_n (GskGpuOp              *op,
   n_ops = self->n_ops;
   for (next = op->next; next; next = next->next)
     {
-      GskGpuShaderOp *next_shader = (GskGpuShaderOp *) next;
-  
-      if (next->op_class != op->op_class ||
-          next_shader->desc != self->desc ||
-          next_shader->color_states != self->color_states ||
-          next_shader->variation != self->variation ||
-          next_shader->clip != self->clip ||
-          next_shader->vertex_offset != self->vertex_offset + n_ops * shader_op_class->vertex_size)
+      if (!gsk_gpu_shader_op_can_merge (self, next, n_ops))
         break;
 
-      n_ops += next_shader->n_ops;
+      n_ops += ((GskGpuShaderOp *) next)->n_ops;
     }
 
   vkCmdBindPipeline (state->vk_command_buffer,
@@ -177,25 +218,15 @@ gsk_gpu_shader_op_gl_command_n (GskGpuOp          *op,
       state->desc = desc;
     }
 
-  if (gsk_gpu_frame_should_optimize (frame, GSK_GPU_OPTIMIZE_MERGE))
-    max_ops_per_draw = MAX_MERGE_OPS;
-  else
-    max_ops_per_draw = 1;
+  max_ops_per_draw = gsk_gpu_shader_op_get_max_ops_per_draw (frame);
 
   n_ops = self->n_ops;
   for (next = op->next; next; next = next->next)
     {
-      GskGpuShaderOp *next_shader = (GskGpuShaderOp *) next;
-
-      if (next->op_class != op->op_class ||
-          next_shader->desc != self->desc ||
-          next_shader->color_states != self->color_states ||
-          next_shader->variation != self->variation ||
-          next_shader->clip != self->clip ||
-          next_shader->vertex_offset != self->vertex_offset + n_ops * shader_op_class->vertex_size)
+      if (!gsk_gpu_shader_op_can_merge (self, next, n_ops))
         break;
 
-      n_ops += next_shader->n_ops;
+      n_ops += ((GskGpuShaderOp *) next)->n_ops;
     }
 
   for (i = 0; i < n_ops; i += max_ops_per_draw)
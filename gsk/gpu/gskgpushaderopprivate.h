@@ -49,6 +49,10 @@ void                    gsk_gpu_shader_op_print                         (GskGpuO
                                                                          GskGpuFrame            *frame,
                                                                          GString                *string,
                                                                          guint                   indent);
+gboolean                gsk_gpu_shader_op_can_merge                     (const GskGpuShaderOp   *self,
+                                                                         const GskGpuOp         *next,
+                                                                         gsize                   n_ops);
+gsize                   gsk_gpu_shader_op_get_max_ops_per_draw          (GskGpuFrame            *frame);
 #ifdef GDK_RENDERING_VULKAN
 GskGpuOp *              gsk_gpu_shader_op_vk_command_n                  (GskGpuOp               *op,
                                                                          GskGpuFrame            *frame,
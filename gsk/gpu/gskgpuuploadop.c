@@ -16,27 +16,24 @@
 #include "gdk/gdkglcontextprivate.h"
 #include "gsk/gskdebugprivate.h"
 
-static GskGpuOp *
-gsk_gpu_upload_op_gl_command_with_area (GskGpuOp                    *op,
-                                        GskGpuFrame                 *frame,
-                                        GskGpuImage                 *image,
-                                        const cairo_rectangle_int_t *area,
-                                        void           (* draw_func) (GskGpuOp *, guchar *, gsize))
+#include <pango/pangocairo.h>
+
+static void
+gsk_gpu_upload_op_gl_upload (GskGpuFrame                 *frame,
+                             GskGpuImage                 *image,
+                             const cairo_rectangle_int_t *area,
+                             const guchar                *data,
+                             gsize                        stride)
 {
   GskGLImage *gl_image = GSK_GL_IMAGE (image);
   GdkMemoryFormat format;
   GdkGLContext *context;
-  gsize stride, bpp;
-  guchar *data;
+  gsize bpp;
   guint gl_format, gl_type;
 
   context = GDK_GL_CONTEXT (gsk_gpu_frame_get_context (frame));
   format = gsk_gpu_image_get_format (image);
   bpp = gdk_memory_format_bytes_per_pixel (format);
-  stride = area->width * bpp;
-  data = g_malloc (area->height * stride);
-
-  draw_func (op, data, stride);
 
   gl_format = gsk_gl_image_get_gl_format (gl_image);
   gl_type = gsk_gl_image_get_gl_type (gl_image);
@@ -69,6 +66,24 @@ gsk_gpu_upload_op_gl_command_with_area (GskGpuOp                    *op,
     }
 
   glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+}
+
+static GskGpuOp *
+gsk_gpu_upload_op_gl_command_with_area (GskGpuOp                    *op,
+                                        GskGpuFrame                 *frame,
+                                        GskGpuImage                 *image,
+                                        const cairo_rectangle_int_t *area,
+                                        void           (* draw_func) (GskGpuOp *, guchar *, gsize))
+{
+  gsize stride;
+  guchar *data;
+
+  stride = area->width * gdk_memory_format_bytes_per_pixel (gsk_gpu_image_get_format (image));
+  data = g_malloc (area->height * stride);
+
+  draw_func (op, data, stride);
+
+  gsk_gpu_upload_op_gl_upload (frame, image, area, data, stride);
 
   g_free (data);
 
@@ -93,27 +108,12 @@ gsk_gpu_upload_op_gl_command (GskGpuOp          *op,
 }
 
 #ifdef GDK_RENDERING_VULKAN
-static GskGpuOp *
-gsk_gpu_upload_op_vk_command_with_area (GskGpuOp                    *op,
-                                        GskGpuFrame                 *frame,
-                                        GskVulkanCommandState       *state,
-                                        GskVulkanImage              *image,
-                                        const cairo_rectangle_int_t *area,
-                                        void           (* draw_func) (GskGpuOp *, guchar *, gsize),
-                                        GskGpuBuffer               **buffer)
+static void
+gsk_gpu_upload_op_vk_copy_buffer (GskVulkanCommandState       *state,
+                                  GskVulkanImage              *image,
+                                  const cairo_rectangle_int_t *area,
+                                  GskGpuBuffer                *buffer)
 {
-  gsize stride;
-  guchar *data;
-
-  stride = area->width * gdk_memory_format_bytes_per_pixel (gsk_gpu_image_get_format (GSK_GPU_IMAGE (image)));
-  *buffer = gsk_vulkan_buffer_new_write (GSK_VULKAN_DEVICE (gsk_gpu_frame_get_device (frame)),
-                                         area->height * stride);
-  data = gsk_gpu_buffer_map (*buffer);
-
-  draw_func (op, data, stride);
-
-  gsk_gpu_buffer_unmap (*buffer, area->height * stride);
-
   vkCmdPipelineBarrier (state->vk_command_buffer,
                         VK_PIPELINE_STAGE_HOST_BIT,
                         VK_PIPELINE_STAGE_TRANSFER_BIT,
@@ -125,7 +125,7 @@ gsk_gpu_upload_op_vk_command_with_area (GskGpuOp                    *op,
                             .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
                             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-                            .buffer = gsk_vulkan_buffer_get_vk_buffer (GSK_VULKAN_BUFFER (*buffer)),
+                            .buffer = gsk_vulkan_buffer_get_vk_buffer (GSK_VULKAN_BUFFER (buffer)),
                             .offset = 0,
                             .size = VK_WHOLE_SIZE,
                         },
@@ -138,7 +138,7 @@ gsk_gpu_upload_op_vk_command_with_area (GskGpuOp                    *op,
                                VK_ACCESS_TRANSFER_WRITE_BIT);
 
   vkCmdCopyBufferToImage (state->vk_command_buffer,
-                          gsk_vulkan_buffer_get_vk_buffer (GSK_VULKAN_BUFFER (*buffer)),
+                          gsk_vulkan_buffer_get_vk_buffer (GSK_VULKAN_BUFFER (buffer)),
                           gsk_vulkan_image_get_vk_image (image),
                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                           1,
@@ -165,6 +165,30 @@ gsk_gpu_upload_op_vk_command_with_area (GskGpuOp                    *op,
                                    }
                                }
                           });
+}
+
+static GskGpuOp *
+gsk_gpu_upload_op_vk_command_with_area (GskGpuOp                    *op,
+                                        GskGpuFrame                 *frame,
+                                        GskVulkanCommandState       *state,
+                                        GskVulkanImage              *image,
+                                        const cairo_rectangle_int_t *area,
+                                        void           (* draw_func) (GskGpuOp *, guchar *, gsize),
+                                        GskGpuBuffer               **buffer)
+{
+  gsize stride;
+  guchar *data;
+
+  stride = area->width * gdk_memory_format_bytes_per_pixel (gsk_gpu_image_get_format (GSK_GPU_IMAGE (image)));
+  *buffer = gsk_vulkan_buffer_new_write (GSK_VULKAN_DEVICE (gsk_gpu_frame_get_device (frame)),
+                                         area->height * stride);
+  data = gsk_gpu_buffer_map (*buffer);
+
+  draw_func (op, data, stride);
+
+  gsk_gpu_buffer_unmap (*buffer, area->height * stride);
+
+  gsk_gpu_upload_op_vk_copy_buffer (state, image, area, *buffer);
 
   return op->next;
 }
@@ -205,7 +229,161 @@ gsk_gpu_upload_op_vk_command (GskGpuOp              *op,
 }
 #endif
 
+/* Some uploads are slow to prepare on the CPU, like rasterizing glyphs
+ * with cairo or converting large textures to another format. Their ops
+ * hand that work to worker threads when they are created, and it runs
+ * while the rest of the frame is being prepared. Where possible, they
+ * write straight into the memory that gets uploaded, so that recording
+ * the upload only has to wait for them.
+ *
+ * Ops get moved around in memory while the frame is built, so the
+ * workers get a job of their own. Jobs are reference counted, so that
+ * several ops can share one, and a job that was never handed to the
+ * workers is run by whoever waits for it first.
+ */
+typedef struct _UploadJob UploadJob;
+
+struct _UploadJob
+{
+  void (* run) (UploadJob *job);
+  void (* finalize) (UploadJob *job);
+
+  guchar *data;
+  gsize stride;
+  gboolean owns_data;
+  guint ref_count;
+  gboolean started;
+  gboolean pending; /* protected by upload_job_mutex */
+};
+
+static GThreadPool *upload_job_pool;
+static GMutex upload_job_mutex;
+static GCond upload_job_cond;
+
+static void
+upload_job_run (gpointer data,
+                gpointer user_data)
+{
+  UploadJob *job = data;
+
+  job->run (job);
+
+  g_mutex_lock (&upload_job_mutex);
+  job->pending = FALSE;
+  g_cond_broadcast (&upload_job_cond);
+  g_mutex_unlock (&upload_job_mutex);
+}
+
+static void
+upload_job_wait (UploadJob *job)
+{
+  if (!job->started)
+    {
+      job->started = TRUE;
+      job->run (job);
+      job->pending = FALSE;
+      return;
+    }
+
+  g_mutex_lock (&upload_job_mutex);
+  while (job->pending)
+    g_cond_wait (&upload_job_cond, &upload_job_mutex);
+  g_mutex_unlock (&upload_job_mutex);
+}
+
+static UploadJob *
+upload_job_ref (UploadJob *job)
+{
+  job->ref_count++;
+
+  return job;
+}
+
+static void
+upload_job_unref (UploadJob *job)
+{
+  job->ref_count--;
+  if (job->ref_count > 0)
+    return;
+
+  if (job->started)
+    upload_job_wait (job);
+
+  job->finalize (job);
+  if (job->owns_data)
+    g_free (job->data);
+  g_free (job);
+}
+
+static GThreadPool *
+upload_job_get_pool (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      guint n_threads = g_get_num_processors ();
+
+      /* Leave one core to the thread preparing the frame */
+      if (n_threads > 1)
+        upload_job_pool = g_thread_pool_new (upload_job_run,
+                                             NULL,
+                                             MIN (n_threads - 1, 4),
+                                             FALSE,
+                                             NULL);
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return upload_job_pool;
+}
+
+/* Allocates a job of the given size that writes height rows of
+ * stride bytes to data, or returns NULL if there are no workers.
+ * If data is NULL, the job allocates the rows itself. Jobs that
+ * don't know their size yet pass 0 and allocate the data when
+ * they run.
+ */
+static gpointer
+upload_job_new (gsize   size,
+                void (* run) (UploadJob *job),
+                void (* finalize) (UploadJob *job),
+                guchar *data,
+                gsize   stride,
+                gsize   height)
+{
+  UploadJob *job;
+
+  if (upload_job_get_pool () == NULL)
+    return NULL;
+
+  job = g_malloc0 (size);
+  job->run = run;
+  job->finalize = finalize;
+  job->stride = stride;
+  if (data)
+    job->data = data;
+  else if (stride * height > 0)
+    job->data = g_malloc (stride * height);
+  job->owns_data = data == NULL;
+  job->ref_count = 1;
+  job->pending = TRUE;
+
+  return job;
+}
+
+static void
+upload_job_start (UploadJob *job)
+{
+  job->started = TRUE;
+  g_thread_pool_push (upload_job_pool, job, NULL);
+}
+
+/* Textures smaller than this are converted when the upload is recorded */
+#define ASYNC_UPLOAD_MIN_PIXELS (256 * 256)
+
 typedef struct _GskGpuUploadTextureOp GskGpuUploadTextureOp;
+typedef struct _TextureConvertJob TextureConvertJob;
 
 struct _GskGpuUploadTextureOp
 {
@@ -214,13 +392,105 @@ struct _GskGpuUploadTextureOp
   GskGpuImage *image;
   GskGpuBuffer *buffer;
   GdkTexture *texture;
+
+  UploadJob *job;
 };
 
+/* Textures in the format of the image are copied straight into the
+ * upload buffer, so only conversions are worth doing in a worker.
+ * Other textures than memory textures may need a GL context or other
+ * renderers to download, so they are always done on the calling thread.
+ */
+struct _TextureConvertJob
+{
+  UploadJob job;
+
+  GdkTexture *texture;
+  GdkMemoryFormat format;
+};
+
+static void
+texture_convert_job_run (UploadJob *job)
+{
+  TextureConvertJob *self = (TextureConvertJob *) job;
+  GdkTextureDownloader *downloader;
+
+  downloader = gdk_texture_downloader_new (self->texture);
+  gdk_texture_downloader_set_format (downloader, self->format);
+  gdk_texture_downloader_download_into (downloader, job->data, job->stride);
+  gdk_texture_downloader_free (downloader);
+}
+
+static void
+texture_convert_job_finalize (UploadJob *job)
+{
+  TextureConvertJob *self = (TextureConvertJob *) job;
+
+  g_object_unref (self->texture);
+}
+
+/* The job converts into the memory that gets uploaded: the mapped
+ * image or a staging buffer with Vulkan, and the rows handed to
+ * glTexSubImage2D() with GL.
+ */
+static void
+gsk_gpu_upload_texture_op_try_start_job (GskGpuUploadTextureOp *self,
+                                         GskGpuFrame           *frame)
+{
+  TextureConvertJob *job;
+  GdkMemoryFormat format;
+  gsize width, height, stride;
+  guchar *data = NULL;
+
+  format = gsk_gpu_image_get_format (self->image);
+  if (!GDK_IS_MEMORY_TEXTURE (self->texture) ||
+      gdk_texture_get_format (self->texture) == format)
+    return;
+
+  width = gdk_texture_get_width (self->texture);
+  height = gdk_texture_get_height (self->texture);
+  if (width * height < ASYNC_UPLOAD_MIN_PIXELS)
+    return;
+
+  if (upload_job_get_pool () == NULL)
+    return;
+
+  stride = width * gdk_memory_format_bytes_per_pixel (format);
+
+#ifdef GDK_RENDERING_VULKAN
+  if (GSK_IS_VULKAN_IMAGE (self->image))
+    {
+      data = gsk_vulkan_image_get_data (GSK_VULKAN_IMAGE (self->image), &stride);
+      if (data == NULL)
+        {
+          stride = width * gdk_memory_format_bytes_per_pixel (format);
+          self->buffer = gsk_vulkan_buffer_new_write (GSK_VULKAN_DEVICE (gsk_gpu_frame_get_device (frame)),
+                                                      height * stride);
+          data = gsk_gpu_buffer_map (self->buffer);
+        }
+    }
+#endif
+
+  job = upload_job_new (sizeof (TextureConvertJob),
+                        texture_convert_job_run,
+                        texture_convert_job_finalize,
+                        data,
+                        stride,
+                        height);
+  job->texture = g_object_ref (self->texture);
+  job->format = format;
+
+  upload_job_start ((UploadJob *) job);
+  self->job = (UploadJob *) job;
+}
+
 static void
 gsk_gpu_upload_texture_op_finish (GskGpuOp *op)
 {
   GskGpuUploadTextureOp *self = (GskGpuUploadTextureOp *) op;
 
+  g_clear_pointer (&self->job, upload_job_unref);
+
   g_object_unref (self->image);
   g_clear_object (&self->buffer);
   g_object_unref (self->texture);
@@ -261,6 +531,26 @@ gsk_gpu_upload_texture_op_vk_command (GskGpuOp              *op,
 {
   GskGpuUploadTextureOp *self = (GskGpuUploadTextureOp *) op;
 
+  if (self->job)
+    {
+      upload_job_wait (self->job);
+
+      if (self->buffer)
+        {
+          gsk_gpu_buffer_unmap (self->buffer, self->job->stride * gsk_gpu_image_get_height (self->image));
+          gsk_gpu_upload_op_vk_copy_buffer (state,
+                                            GSK_VULKAN_IMAGE (self->image),
+                                            &(cairo_rectangle_int_t) {
+                                                0, 0,
+                                                gsk_gpu_image_get_width (self->image),
+                                                gsk_gpu_image_get_height (self->image)
+                                            },
+                                            self->buffer);
+        }
+
+      return op->next;
+    }
+
   return gsk_gpu_upload_op_vk_command (op,
                                        frame,
                                        state,
@@ -277,6 +567,23 @@ gsk_gpu_upload_texture_op_gl_command (GskGpuOp          *op,
 {
   GskGpuUploadTextureOp *self = (GskGpuUploadTextureOp *) op;
 
+  if (self->job)
+    {
+      upload_job_wait (self->job);
+
+      gsk_gpu_upload_op_gl_upload (frame,
+                                   self->image,
+                                   &(cairo_rectangle_int_t) {
+                                       0, 0,
+                                       gsk_gpu_image_get_width (self->image),
+                                       gsk_gpu_image_get_height (self->image)
+                                   },
+                                   self->job->data,
+                                   self->job->stride);
+
+      return op->next;
+    }
+
   return gsk_gpu_upload_op_gl_command (op,
                                        frame,
                                        self->image,
@@ -343,6 +650,8 @@ gsk_gpu_upload_texture_op_try (GskGpuFrame *frame,
 
   self->texture = g_object_ref (texture);
   self->image = image;
+  self->job = NULL;
+  gsk_gpu_upload_texture_op_try_start_job (self, frame);
 
   return self->image;
 }
@@ -488,6 +797,7 @@ gsk_gpu_upload_cairo_op (GskGpuFrame           *frame,
 }
 
 typedef struct _GskGpuUploadGlyphOp GskGpuUploadGlyphOp;
+typedef struct _GlyphRasterizeJob GlyphRasterizeJob;
 
 struct _GskGpuUploadGlyphOp
 {
@@ -500,13 +810,229 @@ struct _GskGpuUploadGlyphOp
   graphene_point_t origin;
 
   GskGpuBuffer *buffer;
+
+  UploadJob *job;
+  gsize offset;
+};
+
+/* Rasterizing glyphs with cairo is slow, and a new font size or script
+ * can easily need hundreds of them in one frame, so they are done by
+ * upload jobs. A job per glyph would cost more in setup than the glyph
+ * takes to draw, so the frame collects the glyphs it is missing into
+ * batches, and hands a batch to the workers once it is full or the
+ * frame is submitted.
+ *
+ * Pango fonts are not safe to use from other threads, so the workers
+ * only ever see the cairo scaled font.
+ */
+#define GLYPH_BATCH_SIZE 32
+
+struct _GlyphRasterizeJob
+{
+  UploadJob job;
+
+  gsize size;
+  guint n_glyphs;
+  struct {
+    cairo_scaled_font_t *scaled_font;
+    PangoGlyph glyph;
+    int width;
+    int height;
+    graphene_point_t origin;
+    gsize offset;
+  } glyphs[GLYPH_BATCH_SIZE];
 };
 
+static cairo_t *
+gsk_gpu_glyph_create_cairo (int                     width,
+                            int                     height,
+                            const graphene_point_t *origin,
+                            guchar                 *data,
+                            gsize                   stride)
+{
+  cairo_surface_t *surface;
+  cairo_t *cr;
+
+  surface = cairo_image_surface_create_for_data (data,
+                                                 CAIRO_FORMAT_ARGB32,
+                                                 width,
+                                                 height,
+                                                 stride);
+  cairo_surface_set_device_offset (surface, origin->x, origin->y);
+
+  cr = cairo_create (surface);
+  cairo_surface_destroy (surface);
+
+  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  cairo_paint (cr);
+  cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+
+  /* Make sure the entire surface is initialized to black */
+  cairo_set_source_rgba (cr, 0, 0, 0, 0);
+  cairo_rectangle (cr, 0.0, 0.0, width, height);
+  cairo_fill (cr);
+
+  /* Draw glyph */
+  cairo_set_source_rgba (cr, 1, 1, 1, 1);
+
+  return cr;
+}
+
+static void
+gsk_gpu_glyph_finish_cairo (cairo_t *cr)
+{
+  cairo_surface_t *surface = cairo_get_target (cr);
+
+  cairo_surface_reference (surface);
+  cairo_destroy (cr);
+
+  cairo_surface_finish (surface);
+  cairo_surface_destroy (surface);
+}
+
+static void
+gsk_gpu_glyph_rasterize (PangoFont              *font,
+                         PangoGlyph              glyph,
+                         int                     width,
+                         int                     height,
+                         const graphene_point_t *origin,
+                         guchar                 *data,
+                         gsize                   stride)
+{
+  cairo_t *cr;
+  PangoRectangle ink_rect = { 0, };
+
+  cr = gsk_gpu_glyph_create_cairo (width, height, origin, data, stride);
+
+  /* The pango code for drawing hex boxes uses the glyph width */
+  if (glyph & PANGO_GLYPH_UNKNOWN_FLAG)
+    pango_font_get_glyph_extents (font, glyph, &ink_rect, NULL);
+
+  pango_cairo_show_glyph_string (cr,
+                                 font,
+                                 &(PangoGlyphString) {
+                                     .num_glyphs = 1,
+                                     .glyphs = (PangoGlyphInfo[1]) { {
+                                         .glyph = glyph,
+                                         .geometry = {
+                                           .width = ink_rect.width,
+                                         }
+                                     } }
+                                 });
+
+  gsk_gpu_glyph_finish_cairo (cr);
+}
+
+static void
+glyph_rasterize_job_run (UploadJob *job)
+{
+  GlyphRasterizeJob *self = (GlyphRasterizeJob *) job;
+  guint i;
+
+  job->data = g_malloc (self->size);
+
+  for (i = 0; i < self->n_glyphs; i++)
+    {
+      cairo_t *cr;
+
+      cr = gsk_gpu_glyph_create_cairo (self->glyphs[i].width,
+                                       self->glyphs[i].height,
+                                       &self->glyphs[i].origin,
+                                       job->data + self->glyphs[i].offset,
+                                       self->glyphs[i].width * 4);
+
+      cairo_set_scaled_font (cr, self->glyphs[i].scaled_font);
+      cairo_show_glyphs (cr, &(cairo_glyph_t) { self->glyphs[i].glyph, 0, 0 }, 1);
+
+      gsk_gpu_glyph_finish_cairo (cr);
+    }
+}
+
+static void
+glyph_rasterize_job_finalize (UploadJob *job)
+{
+  GlyphRasterizeJob *self = (GlyphRasterizeJob *) job;
+  guint i;
+
+  for (i = 0; i < self->n_glyphs; i++)
+    cairo_scaled_font_destroy (self->glyphs[i].scaled_font);
+}
+
+/* Adds the glyph to the frame's current batch and returns the batch
+ * and the offset of the glyph's pixels in its data. If there are no
+ * workers, out_job is left alone.
+ */
+static void
+glyph_rasterize_job_add (GskGpuFrame                 *frame,
+                         cairo_scaled_font_t         *scaled_font,
+                         PangoGlyph                   glyph,
+                         const cairo_rectangle_int_t *area,
+                         const graphene_point_t      *origin,
+                         UploadJob                  **out_job,
+                         gsize                       *out_offset)
+{
+  GlyphRasterizeJob *self;
+  guint i;
+
+  self = gsk_gpu_frame_get_glyph_batch (frame);
+  if (self == NULL)
+    {
+      self = upload_job_new (sizeof (GlyphRasterizeJob),
+                             glyph_rasterize_job_run,
+                             glyph_rasterize_job_finalize,
+                             NULL, 0, 0);
+      if (self == NULL)
+        return;
+
+      gsk_gpu_frame_set_glyph_batch (frame, self);
+    }
+  else
+    {
+      upload_job_ref ((UploadJob *) self);
+    }
+
+  i = self->n_glyphs++;
+  self->glyphs[i].scaled_font = cairo_scaled_font_reference (scaled_font);
+  self->glyphs[i].glyph = glyph;
+  self->glyphs[i].width = area->width;
+  self->glyphs[i].height = area->height;
+  self->glyphs[i].origin = *origin;
+  self->glyphs[i].offset = self->size;
+  self->size += (gsize) area->width * 4 * area->height;
+
+  *out_job = (UploadJob *) self;
+  *out_offset = self->glyphs[i].offset;
+
+  if (self->n_glyphs == GLYPH_BATCH_SIZE)
+    gsk_gpu_upload_glyph_ops_flush (frame);
+}
+
+/**
+ * gsk_gpu_upload_glyph_ops_flush:
+ * @frame: a `GskGpuFrame`
+ *
+ * Hands the glyphs collected by the frame so far to the workers.
+ */
+void
+gsk_gpu_upload_glyph_ops_flush (GskGpuFrame *frame)
+{
+  UploadJob *job;
+
+  job = gsk_gpu_frame_get_glyph_batch (frame);
+  if (job == NULL)
+    return;
+
+  gsk_gpu_frame_set_glyph_batch (frame, NULL);
+  upload_job_start (job);
+}
+
 static void
 gsk_gpu_upload_glyph_op_finish (GskGpuOp *op)
 {
   GskGpuUploadGlyphOp *self = (GskGpuUploadGlyphOp *) op;
 
+  g_clear_pointer (&self->job, upload_job_unref);
+
   g_object_unref (self->image);
   g_object_unref (self->font);
 
@@ -541,50 +1067,25 @@ gsk_gpu_upload_glyph_op_draw (GskGpuOp *op,
                               gsize     stride)
 {
   GskGpuUploadGlyphOp *self = (GskGpuUploadGlyphOp *) op;
-  cairo_surface_t *surface;
-  cairo_t *cr;
-  PangoRectangle ink_rect = { 0, };
-
-  surface = cairo_image_surface_create_for_data (data,
-                                                 CAIRO_FORMAT_ARGB32,
-                                                 self->area.width,
-                                                 self->area.height,
-                                                 stride);
-  cairo_surface_set_device_offset (surface, self->origin.x, self->origin.y);
-
-  cr = cairo_create (surface);
-  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
-  cairo_paint (cr);
-  cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
-
-  /* Make sure the entire surface is initialized to black */
-  cairo_set_source_rgba (cr, 0, 0, 0, 0);
-  cairo_rectangle (cr, 0.0, 0.0, self->area.width, self->area.height);
-  cairo_fill (cr);
-
-  /* Draw glyph */
-  cairo_set_source_rgba (cr, 1, 1, 1, 1);
-
-  /* The pango code for drawing hex boxes uses the glyph width */
-  if (self->glyph & PANGO_GLYPH_UNKNOWN_FLAG)
-    pango_font_get_glyph_extents (self->font, self->glyph, &ink_rect, NULL);
+  gsize y, glyph_stride;
 
-  pango_cairo_show_glyph_string (cr,
-                                 self->font,
-                                 &(PangoGlyphString) {
-                                     .num_glyphs = 1,
-                                     .glyphs = (PangoGlyphInfo[1]) { {
-                                         .glyph = self->glyph,
-                                         .geometry = {
-                                           .width = ink_rect.width,
-                                         }
-                                     } }
-                                 });
+  if (self->job == NULL)
+    {
+      gsk_gpu_glyph_rasterize (self->font,
+                               self->glyph,
+                               self->area.width,
+                               self->area.height,
+                               &self->origin,
+                               data,
+                               stride);
+      return;
+    }
 
-  cairo_destroy (cr);
+  upload_job_wait (self->job);
 
-  cairo_surface_finish (surface);
-  cairo_surface_destroy (surface);
+  glyph_stride = (gsize) self->area.width * 4;
+  for (y = 0; y < self->area.height; y++)
+    memcpy (data + y * stride, self->job->data + self->offset + y * glyph_stride, glyph_stride);
 }
 
 #ifdef GDK_RENDERING_VULKAN
@@ -639,6 +1140,7 @@ gsk_gpu_upload_glyph_op (GskGpuFrame                 *frame,
                          const graphene_point_t      *origin)
 {
   GskGpuUploadGlyphOp *self;
+  cairo_scaled_font_t *scaled_font;
 
   self = (GskGpuUploadGlyphOp *) gsk_gpu_op_alloc (frame, &GSK_GPU_UPLOAD_GLYPH_OP_CLASS);
 
@@ -647,4 +1149,17 @@ gsk_gpu_upload_glyph_op (GskGpuFrame                 *frame,
   self->font = g_object_ref (font);
   self->glyph = glyph;
   self->origin = *origin;
+  self->job = NULL;
+
+  /* Hex boxes for unknown glyphs are drawn by pango with state that
+   * isn't safe to create from other threads, and there are few of them.
+   */
+  if (glyph & PANGO_GLYPH_UNKNOWN_FLAG || !PANGO_IS_CAIRO_FONT (font))
+    return;
+
+  scaled_font = pango_cairo_font_get_scaled_font (PANGO_CAIRO_FONT (font));
+  if (scaled_font == NULL || cairo_scaled_font_status (scaled_font) != CAIRO_STATUS_SUCCESS)
+    return;
+
+  glyph_rasterize_job_add (frame, scaled_font, glyph, area, origin, &self->job, &self->offset);
 }
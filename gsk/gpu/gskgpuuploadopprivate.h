@@ -26,6 +26,7 @@ void                    gsk_gpu_upload_glyph_op                         (GskGpuF
                                                                          PangoGlyph                      glyph,
                                                                          const cairo_rectangle_int_t    *area,
                                                                          const graphene_point_t         *origin);
+void                    gsk_gpu_upload_glyph_ops_flush                  (GskGpuFrame                    *frame);
 
 G_END_DECLS
 
@@ -509,9 +509,9 @@ gtk_css_token_init_string (GtkCssToken     *token,
     case GTK_CSS_TOKEN_URL:
       token->string.len = string->len;
       if (string->len < 16)
-        g_strlcpy (token->string.u.buf, string->str, 16);
+        memcpy (token->string.u.buf, string->str, string->len + 1);
       else
-        token->string.u.string = g_strdup (string->str);
+        token->string.u.string = g_strndup (string->str, string->len);
       break;
     default:
       g_assert_not_reached ();
@@ -845,6 +845,49 @@ gtk_css_tokenizer_consume_char (GtkCssTokenizer *tokenizer,
     }
 }
 
+/* Appends the longest run of characters that can be copied
+ * verbatim in one go, instead of character by character.
+ * Only escapes, newlines and the terminating characters need
+ * to go through the slow path.
+ */
+static void
+gtk_css_tokenizer_append_name_run (GtkCssTokenizer *tokenizer,
+                                   GString         *string)
+{
+  const char *data = tokenizer->data;
+  gsize n_characters = 0;
+
+  while (data < tokenizer->end && is_name (*data))
+    {
+      data = MIN (g_utf8_next_char (data), tokenizer->end);
+      n_characters++;
+    }
+
+  g_string_append_len (string, tokenizer->data, data - tokenizer->data);
+  gtk_css_tokenizer_consume (tokenizer, data - tokenizer->data, n_characters);
+}
+
+static void
+gtk_css_tokenizer_append_string_run (GtkCssTokenizer *tokenizer,
+                                     GString         *string,
+                                     char             end)
+{
+  const char *data = tokenizer->data;
+  gsize n_characters = 0;
+
+  while (data < tokenizer->end &&
+         *data != end &&
+         *data != '\\' &&
+         !is_newline (*data))
+    {
+      data = MIN (g_utf8_next_char (data), tokenizer->end);
+      n_characters++;
+    }
+
+  g_string_append_len (string, tokenizer->data, data - tokenizer->data);
+  gtk_css_tokenizer_consume (tokenizer, data - tokenizer->data, n_characters);
+}
+
 static void
 gtk_css_tokenizer_read_whitespace (GtkCssTokenizer *tokenizer,
                                    GtkCssToken     *token)
@@ -923,7 +966,7 @@ gtk_css_tokenizer_read_name (GtkCssTokenizer *tokenizer)
         }
       else if (is_name (*tokenizer->data))
         {
-          gtk_css_tokenizer_consume_char (tokenizer, tokenizer->name_buffer);
+          gtk_css_tokenizer_append_name_run (tokenizer, tokenizer->name_buffer);
         }
       else
         {
@@ -1252,7 +1295,7 @@ gtk_css_tokenizer_read_string (GtkCssTokenizer  *tokenizer,
         }
       else
         {
-          gtk_css_tokenizer_consume_char (tokenizer, tokenizer->name_buffer);
+          gtk_css_tokenizer_append_string_run (tokenizer, tokenizer->name_buffer, end);
         }
     }
 
@@ -153,7 +153,10 @@ static void
 gtk_style_context_cascade_changed (GtkStyleCascade *cascade,
                                    GtkStyleContext *context)
 {
-  gtk_css_node_invalidate_style_provider (gtk_style_context_get_root (context));
+  if (gtk_style_provider_is_rules_change ())
+    gtk_css_node_invalidate_style_rules (gtk_style_context_get_root (context));
+  else
+    gtk_css_node_invalidate_style_provider (gtk_style_context_get_root (context));
 }
 
 static void
@@ -31,6 +31,7 @@
 #include "gtkcssshadowvalueprivate.h"
 
 #include <math.h>
+#include <string.h>
 
 #include <pango/pango.h>
 #include <cairo.h>
@@ -89,6 +90,132 @@ set_color (GskPangoRenderer *crenderer,
   gdk_cairo_set_source_rgba (cr, &rgba);
 }
 
+/* Text node cache
+ *
+ * Widgets snapshot their text relative to their own origin, so rows of
+ * a list or cells of a grid keep asking for the same short runs of
+ * glyphs at the same offset and in the same color. Text nodes are
+ * immutable, so we can hand out the same node to all of them instead
+ * of copying the glyphs and querying the font for their extents every
+ * time.
+ *
+ * The cache is direct-mapped: every run hashes to one slot and replaces
+ * whatever was cached there, which keeps its size fixed without having
+ * to track the age of entries.
+ */
+
+#define TEXT_NODE_CACHE_SIZE 256
+#define TEXT_NODE_CACHE_MAX_GLYPHS 32
+
+typedef struct
+{
+  guint hash;
+  int num_glyphs;
+  PangoGlyphInfo *glyphs;
+  GskRenderNode *node;
+} TextNodeCacheEntry;
+
+static TextNodeCacheEntry text_node_cache[TEXT_NODE_CACHE_SIZE]; /* MT-safe */
+G_LOCK_DEFINE_STATIC (text_node_cache);
+
+static guint
+text_node_cache_hash (PangoFont              *font,
+                      PangoGlyphString       *glyphs,
+                      const GdkRGBA          *color,
+                      const graphene_point_t *offset)
+{
+  guint hash;
+  int i;
+
+  hash = g_direct_hash (font);
+  hash = hash * 31 + gdk_rgba_hash (color);
+  hash = hash * 31 + (guint) (int) (offset->x * 64);
+  hash = hash * 31 + (guint) (int) (offset->y * 64);
+
+  for (i = 0; i < glyphs->num_glyphs; i++)
+    {
+      hash = hash * 31 + glyphs->glyphs[i].glyph;
+      hash = hash * 31 + glyphs->glyphs[i].geometry.width;
+    }
+
+  return hash;
+}
+
+static gboolean
+text_node_cache_entry_matches (const TextNodeCacheEntry *entry,
+                               guint                     hash,
+                               PangoFont                *font,
+                               PangoGlyphString         *glyphs,
+                               const GdkRGBA            *color,
+                               const graphene_point_t   *offset)
+{
+  return entry->node != NULL &&
+         entry->hash == hash &&
+         entry->num_glyphs == glyphs->num_glyphs &&
+         gsk_text_node_get_font (entry->node) == font &&
+         gdk_rgba_equal (gsk_text_node_get_color (entry->node), color) &&
+         graphene_point_equal (gsk_text_node_get_offset (entry->node), offset) &&
+         memcmp (entry->glyphs, glyphs->glyphs, sizeof (PangoGlyphInfo) * glyphs->num_glyphs) == 0;
+}
+
+/*
+ * gsk_pango_text_node_get:
+ * @font: the font to use
+ * @glyphs: the glyphs to render
+ * @color: the color to render the glyphs in
+ * @offset: the offset of the baseline
+ *
+ * Returns a text node for the given glyphs, reusing a previously
+ * created one if possible.
+ *
+ * Returns: (transfer full) (nullable): a text node, or %NULL if
+ *   the glyphs are not visible
+ */
+GskRenderNode *
+gsk_pango_text_node_get (PangoFont              *font,
+                         PangoGlyphString       *glyphs,
+                         const GdkRGBA          *color,
+                         const graphene_point_t *offset)
+{
+  TextNodeCacheEntry *entry;
+  GskRenderNode *node;
+  guint hash;
+
+  if (glyphs->num_glyphs > TEXT_NODE_CACHE_MAX_GLYPHS)
+    return gsk_text_node_new (font, glyphs, color, offset);
+
+  hash = text_node_cache_hash (font, glyphs, color, offset);
+  entry = &text_node_cache[hash % TEXT_NODE_CACHE_SIZE];
+
+  G_LOCK (text_node_cache);
+
+  if (text_node_cache_entry_matches (entry, hash, font, glyphs, color, offset))
+    {
+      node = gsk_render_node_ref (entry->node);
+      G_UNLOCK (text_node_cache);
+      return node;
+    }
+
+  G_UNLOCK (text_node_cache);
+
+  node = gsk_text_node_new (font, glyphs, color, offset);
+  if (node == NULL)
+    return NULL;
+
+  G_LOCK (text_node_cache);
+
+  g_clear_pointer (&entry->node, gsk_render_node_unref);
+  g_free (entry->glyphs);
+  entry->hash = hash;
+  entry->num_glyphs = glyphs->num_glyphs;
+  entry->glyphs = g_memdup2 (glyphs->glyphs, sizeof (PangoGlyphInfo) * glyphs->num_glyphs);
+  entry->node = gsk_render_node_ref (node);
+
+  G_UNLOCK (text_node_cache);
+
+  return node;
+}
+
 static void
 gsk_pango_renderer_draw_glyph_item (PangoRenderer  *renderer,
                                     const char     *text,
@@ -84,5 +84,10 @@ void              gsk_pango_renderer_set_shape_handler (GskPangoRenderer      *c
 GskPangoRenderer *gsk_pango_renderer_acquire   (void);
 void              gsk_pango_renderer_release   (GskPangoRenderer      *crenderer);
 
+GskRenderNode    *gsk_pango_text_node_get      (PangoFont              *font,
+                                                PangoGlyphString       *glyphs,
+                                                const GdkRGBA          *color,
+                                                const graphene_point_t *offset);
+
 G_END_DECLS
 
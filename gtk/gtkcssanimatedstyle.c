@@ -1094,7 +1094,7 @@ gtk_css_animated_style_new_advance (GtkCssAnimatedStyle *source,
         continue;
 
       if (!animations)
-        animations = g_ptr_array_sized_new (16);
+        animations = g_ptr_array_sized_new (source->n_animations);
 
       animation = _gtk_style_animation_advance (animation, timestamp);
       g_ptr_array_add (animations, animation);
@@ -74,6 +74,65 @@ gtk_css_animation_get_progress (GtkCssAnimation *animation)
   return gtk_progress_tracker_get_progress (&animation->tracker, reverse);
 }
 
+static void
+gtk_css_animation_clear_resolved (GtkCssAnimation *animation)
+{
+  g_clear_pointer (&animation->resolved_keyframes, _gtk_css_keyframes_unref);
+  g_clear_object (&animation->resolved_style);
+  g_clear_object (&animation->resolved_parent_style);
+  g_clear_object (&animation->resolved_provider);
+}
+
+static void
+gtk_css_animation_copy_resolved (GtkCssAnimation *source,
+                                 GtkCssAnimation *animation)
+{
+  if (source->resolved_keyframes == NULL)
+    {
+      animation->resolved_keyframes = NULL;
+      animation->resolved_style = NULL;
+      animation->resolved_parent_style = NULL;
+      animation->resolved_provider = NULL;
+      return;
+    }
+
+  animation->resolved_keyframes = _gtk_css_keyframes_ref (source->resolved_keyframes);
+  animation->resolved_style = g_object_ref (source->resolved_style);
+  animation->resolved_parent_style = source->resolved_parent_style ? g_object_ref (source->resolved_parent_style) : NULL;
+  animation->resolved_provider = g_object_ref (source->resolved_provider);
+}
+
+/* Computing the keyframes is the expensive part of applying an
+ * animation, but the result only depends on the styles, not on the
+ * progress. So we keep it around for as long as the base style and
+ * the parent style don't change, which is the common case for
+ * spinners and other looping animations.
+ */
+static GtkCssKeyframes *
+gtk_css_animation_get_resolved_keyframes (GtkCssAnimation  *animation,
+                                          GtkStyleProvider *provider,
+                                          GtkCssStyle      *base_style,
+                                          GtkCssStyle      *parent_style)
+{
+  if (animation->resolved_keyframes == NULL ||
+      animation->resolved_style != base_style ||
+      animation->resolved_parent_style != parent_style ||
+      animation->resolved_provider != provider)
+    {
+      gtk_css_animation_clear_resolved (animation);
+
+      animation->resolved_keyframes = _gtk_css_keyframes_compute (animation->keyframes,
+                                                                  provider,
+                                                                  base_style,
+                                                                  parent_style);
+      animation->resolved_style = g_object_ref (base_style);
+      animation->resolved_parent_style = parent_style ? g_object_ref (parent_style) : NULL;
+      animation->resolved_provider = g_object_ref (provider);
+    }
+
+  return animation->resolved_keyframes;
+}
+
 static GtkStyleAnimation *
 gtk_css_animation_advance (GtkStyleAnimation    *style_animation,
                            gint64                timestamp)
@@ -106,10 +165,10 @@ gtk_css_animation_apply_values (GtkStyleAnimation    *style_animation,
   base_style = gtk_css_animated_style_get_base_style (style);
   parent_style = gtk_css_animated_style_get_parent_style (style);
   provider = gtk_css_animated_style_get_provider (style);
-  resolved_keyframes = _gtk_css_keyframes_compute (animation->keyframes,
-                                                   provider,
-                                                   base_style,
-                                                   parent_style);
+  resolved_keyframes = gtk_css_animation_get_resolved_keyframes (animation,
+                                                                 provider,
+                                                                 base_style,
+                                                                 parent_style);
 
   for (i = 0; i < _gtk_css_keyframes_get_n_variables (resolved_keyframes); i++)
     {
@@ -148,8 +207,6 @@ gtk_css_animation_apply_values (GtkStyleAnimation    *style_animation,
                                             gtk_css_animated_style_get_intrinsic_value (style, property_id));
       gtk_css_animated_style_set_animated_value (style, property_id, value);
     }
-
-  _gtk_css_keyframes_unref (resolved_keyframes);
 }
 
 static gboolean
@@ -177,6 +234,7 @@ gtk_css_animation_free (GtkStyleAnimation *animation)
   g_free (self->name);
   _gtk_css_keyframes_unref (self->keyframes);
   gtk_css_value_unref (self->ease);
+  gtk_css_animation_clear_resolved (self);
 
   g_free (self);
 }
@@ -220,6 +278,10 @@ _gtk_css_animation_new (const char      *name,
   animation->direction = direction;
   animation->play_state = play_state;
   animation->fill_mode = fill_mode;
+  animation->resolved_keyframes = NULL;
+  animation->resolved_style = NULL;
+  animation->resolved_parent_style = NULL;
+  animation->resolved_provider = NULL;
 
   gtk_progress_tracker_start (&animation->tracker, duration_us, delay_us, iteration_count);
   if (animation->play_state == GTK_CSS_PLAY_STATE_PAUSED)
@@ -251,6 +313,7 @@ _gtk_css_animation_advance_with_play_state (GtkCssAnimation *source,
   animation->direction = source->direction;
   animation->play_state = play_state;
   animation->fill_mode = source->fill_mode;
+  gtk_css_animation_copy_resolved (source, animation);
 
   gtk_progress_tracker_init_copy (&source->tracker, &animation->tracker);
   if (animation->play_state == GTK_CSS_PLAY_STATE_PAUSED)
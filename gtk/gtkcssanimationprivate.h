@@ -40,6 +40,13 @@ struct _GtkCssAnimation
   GtkCssPlayState  play_state;
   GtkCssFillMode   fill_mode;
   GtkProgressTracker tracker;
+
+  /* keyframes resolved against the styles below, shared
+   * between all frames of this animation */
+  GtkCssKeyframes *resolved_keyframes;
+  GtkCssStyle     *resolved_style;
+  GtkCssStyle     *resolved_parent_style;
+  GtkStyleProvider *resolved_provider;
 };
 
 struct _GtkCssAnimationClass
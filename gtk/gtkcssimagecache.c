@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2026 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtkcssimagecacheprivate.h"
+
+#include "gdk/gdkmemoryformatprivate.h"
+
+#include <string.h>
+
+/* The same image file is often referenced from many places in a theme,
+ * and from every provider that gets loaded. Each of those values used
+ * to load its own texture. This cache makes them share one.
+ *
+ * The cache only holds weak references, so textures are freed when the
+ * last style using them goes away. Providers collect the files they
+ * reference while loading, and drop just those from the cache when they
+ * get reset, so that reloading CSS picks up changed files without
+ * affecting the images of other providers.
+ */
+
+typedef struct _CacheEntry CacheEntry;
+
+struct _CacheEntry
+{
+  GFile *file;
+  GtkCssImageCacheKind kind;
+  GWeakRef texture;
+};
+
+static GHashTable *image_cache;
+static GHashTable *tracked_files;
+/* Number of entries after the last time dead ones were pruned */
+static guint n_pruned_entries;
+
+static guint
+cache_entry_hash (gconstpointer data)
+{
+  const CacheEntry *entry = data;
+
+  return g_file_hash (entry->file) ^ entry->kind;
+}
+
+static gboolean
+cache_entry_equal (gconstpointer a,
+                   gconstpointer b)
+{
+  const CacheEntry *entry1 = a;
+  const CacheEntry *entry2 = b;
+
+  return entry1->kind == entry2->kind &&
+         g_file_equal (entry1->file, entry2->file);
+}
+
+static void
+cache_entry_free (gpointer data)
+{
+  CacheEntry *entry = data;
+
+  g_object_unref (entry->file);
+  g_weak_ref_clear (&entry->texture);
+  g_free (entry);
+}
+
+static void
+ensure_image_cache (void)
+{
+  if (image_cache == NULL)
+    image_cache = g_hash_table_new_full (cache_entry_hash, cache_entry_equal, cache_entry_free, NULL);
+}
+
+/* Returns a new reference to the cached texture, or %NULL */
+GdkTexture *
+gtk_css_image_cache_lookup (GFile                *file,
+                            GtkCssImageCacheKind  kind)
+{
+  CacheEntry lookup = { file, kind, };
+  CacheEntry *entry;
+  GdkTexture *texture = NULL;
+
+  ensure_image_cache ();
+
+  entry = g_hash_table_lookup (image_cache, &lookup);
+  if (entry)
+    {
+      texture = g_weak_ref_get (&entry->texture);
+      if (texture == NULL)
+        g_hash_table_remove (image_cache, entry);
+    }
+
+  return texture;
+}
+
+static gboolean
+cache_entry_is_dead (CacheEntry *entry)
+{
+  GdkTexture *texture = g_weak_ref_get (&entry->texture);
+
+  if (texture == NULL)
+    return TRUE;
+
+  g_object_unref (texture);
+  return FALSE;
+}
+
+static void
+prune_dead_entries (void)
+{
+  GHashTableIter iter;
+  CacheEntry *entry;
+
+  g_hash_table_iter_init (&iter, image_cache);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &entry, NULL))
+    {
+      if (cache_entry_is_dead (entry))
+        g_hash_table_iter_remove (&iter);
+    }
+
+  n_pruned_entries = g_hash_table_size (image_cache);
+}
+
+void
+gtk_css_image_cache_insert (GFile                *file,
+                            GtkCssImageCacheKind  kind,
+                            GdkTexture           *texture)
+{
+  CacheEntry *entry;
+
+  ensure_image_cache ();
+
+  /* Textures of files that are never looked up again leave dead
+   * entries behind. Pruning whenever the cache doubled in size
+   * keeps that bounded without walking it on every insert.
+   */
+  if (g_hash_table_size (image_cache) >= MAX (2 * n_pruned_entries, 64))
+    prune_dead_entries ();
+
+  entry = g_new0 (CacheEntry, 1);
+  entry->file = g_object_ref (file);
+  entry->kind = kind;
+  g_weak_ref_init (&entry->texture, texture);
+
+  g_hash_table_replace (image_cache, entry, entry);
+}
+
+/* Sets the set of files that referenced image files get added to,
+ * and returns the previous one. Pass %NULL to stop collecting.
+ */
+GHashTable *
+gtk_css_image_cache_track_files (GHashTable *files)
+{
+  GHashTable *previous = tracked_files;
+
+  tracked_files = files;
+
+  return previous;
+}
+
+void
+gtk_css_image_cache_add_reference (GFile *file)
+{
+  if (tracked_files && !g_hash_table_contains (tracked_files, file))
+    g_hash_table_add (tracked_files, g_object_ref (file));
+}
+
+void
+gtk_css_image_cache_remove_files (GHashTable *files)
+{
+  GHashTableIter iter;
+  CacheEntry *entry;
+
+  if (image_cache == NULL || g_hash_table_size (files) == 0)
+    return;
+
+  /* We walk the whole cache anyway, so drop dead entries too */
+  g_hash_table_iter_init (&iter, image_cache);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &entry, NULL))
+    {
+      if (g_hash_table_contains (files, entry->file) ||
+          cache_entry_is_dead (entry))
+        g_hash_table_iter_remove (&iter);
+    }
+
+  n_pruned_entries = g_hash_table_size (image_cache);
+}
+
+void
+gtk_css_image_cache_get_stats (GtkCssImageCacheStats *stats)
+{
+  GHashTableIter iter;
+  CacheEntry *entry;
+
+  memset (stats, 0, sizeof (GtkCssImageCacheStats));
+
+  if (image_cache == NULL)
+    return;
+
+  g_hash_table_iter_init (&iter, image_cache);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &entry, NULL))
+    {
+      GdkTexture *texture = g_weak_ref_get (&entry->texture);
+
+      if (texture == NULL)
+        continue;
+
+      stats->n_textures++;
+      stats->texture_size += (gsize) gdk_texture_get_width (texture) *
+                             gdk_texture_get_height (texture) *
+                             gdk_memory_format_bytes_per_pixel (gdk_texture_get_format (texture));
+      g_object_unref (texture);
+    }
+}
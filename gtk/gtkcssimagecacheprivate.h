@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2024 Red Hat Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gdk/gdk.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  GTK_CSS_IMAGE_CACHE_TEXTURE,
+  GTK_CSS_IMAGE_CACHE_SYMBOLIC,
+} GtkCssImageCacheKind;
+
+typedef struct _GtkCssImageCacheStats GtkCssImageCacheStats;
+
+struct _GtkCssImageCacheStats
+{
+  guint n_textures;
+  gsize texture_size;
+};
+
+GdkTexture *    gtk_css_image_cache_lookup      (GFile                  *file,
+                                                 GtkCssImageCacheKind    kind);
+void            gtk_css_image_cache_insert      (GFile                  *file,
+                                                 GtkCssImageCacheKind    kind,
+                                                 GdkTexture             *texture);
+GHashTable *    gtk_css_image_cache_track_files (GHashTable             *files);
+void            gtk_css_image_cache_add_reference
+                                                (GFile                  *file);
+void            gtk_css_image_cache_remove_files
+                                                (GHashTable             *files);
+
+void            gtk_css_image_cache_get_stats   (GtkCssImageCacheStats  *stats);
+
+G_END_DECLS
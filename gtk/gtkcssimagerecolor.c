@@ -21,6 +21,7 @@
 
 #include "gtkcssimagerecolorprivate.h"
 #include "gtkcssimageprivate.h"
+#include "gtkcssimagecacheprivate.h"
 #include "gtkcsspalettevalueprivate.h"
 #include "gtkcsscolorvalueprivate.h"
 #include "gdktextureutilsprivate.h"
@@ -69,6 +70,10 @@ gtk_css_image_recolor_load_texture (GtkCssImageRecolor  *recolor,
   char *uri;
   gboolean only_fg;
 
+  if (recolor->texture)
+    return;
+
+  recolor->texture = gtk_css_image_cache_lookup (recolor->file, GTK_CSS_IMAGE_CACHE_SYMBOLIC);
   if (recolor->texture)
     return;
 
@@ -93,6 +98,9 @@ gtk_css_image_recolor_load_texture (GtkCssImageRecolor  *recolor,
         recolor->texture = gdk_texture_new_from_file_symbolic (recolor->file, 0, 0, 1.0, &only_fg, NULL);
     }
 
+  if (recolor->texture)
+    gtk_css_image_cache_insert (recolor->file, GTK_CSS_IMAGE_CACHE_SYMBOLIC, recolor->texture);
+
   g_free (uri);
 }
 
@@ -239,6 +247,7 @@ gtk_css_image_recolor_parse_arg (GtkCssParser *parser,
         g_free (url);
         if (self->file == NULL)
           return 0;
+        gtk_css_image_cache_add_reference (self->file);
         return 1;
       }
 
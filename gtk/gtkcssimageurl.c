@@ -23,6 +23,7 @@
 
 #include "gtkcssimageurlprivate.h"
 
+#include "gtkcssimagecacheprivate.h"
 #include "gtkcssimageinvalidprivate.h"
 #include "gtkcssimagepaintableprivate.h"
 #include "gtkstyleproviderprivate.h"
@@ -47,7 +48,13 @@ gtk_css_image_url_load_image (GtkCssImageUrl  *url,
       return url->loaded_image;
     }
 
-  texture = gdk_texture_new_from_file (url->file, &local_error);
+  texture = gtk_css_image_cache_lookup (url->file, GTK_CSS_IMAGE_CACHE_TEXTURE);
+  if (texture == NULL)
+    {
+      texture = gdk_texture_new_from_file (url->file, &local_error);
+      if (texture)
+        gtk_css_image_cache_insert (url->file, GTK_CSS_IMAGE_CACHE_TEXTURE, texture);
+    }
 
   if (texture == NULL)
     {
@@ -224,6 +231,8 @@ gtk_css_image_url_parse (GtkCssImage  *image,
   else
     {
       self->file = gtk_css_parser_resolve_url (parser, url);
+      if (self->file)
+        gtk_css_image_cache_add_reference (self->file);
     }
 
   g_free (url);
@@ -24,10 +24,13 @@
 #include "gtkcssstylepropertyprivate.h"
 #include "gtkmarshalers.h"
 #include "gtksettingsprivate.h"
+#include "gtkstyleproviderprivate.h"
 #include "gtktypebuiltins.h"
 #include "gtkprivate.h"
 #include "gdkprofilerprivate.h"
 
+#include <string.h>
+
 /*
  * CSS nodes are the backbone of the GtkStyleContext implementation and
  * replace the role that GtkWidgetPath played in the past. A CSS node has
@@ -123,8 +126,25 @@ gtk_css_node_get_style_provider_or_null (GtkCssNode *cssnode)
 
 static int invalidated_nodes;
 static int created_styles;
+static int advanced_styles;
 static guint invalidated_nodes_counter;
 static guint created_styles_counter;
+static guint advanced_styles_counter;
+
+/* Cumulative statistics, for the inspector */
+static GtkCssNodeStats node_stats;
+static gboolean record_stats;
+/* char *description => GtkCssNodeTriggerStats */
+static GHashTable *trigger_stats;
+/* char *description => number of times, since the last validation */
+static GHashTable *pending_triggers;
+
+/* Descriptions contain names, ids and classes, so there is no bound
+ * on how many distinct ones an application produces. Once this many
+ * have been seen, the rest are counted together.
+ */
+#define MAX_TRIGGER_STATS 500
+#define OTHER_TRIGGERS "(other changes)"
 
 static void
 gtk_css_node_set_invalid (GtkCssNode *node,
@@ -136,7 +156,10 @@ gtk_css_node_set_invalid (GtkCssNode *node,
   node->invalid = invalid;
 
   if (invalid)
-    invalidated_nodes++;
+    {
+      invalidated_nodes++;
+      node_stats.invalidated_nodes++;
+    }
 
   if (node->visible)
     {
@@ -317,7 +340,10 @@ lookup_in_global_parent_cache (GtkCssNode                  *node,
     return NULL;
 
   if (parent->cache == NULL)
-    return NULL;
+    {
+      node_stats.cache_misses++;
+      return NULL;
+    }
 
   g_assert (node->cache == NULL);
   node->cache = gtk_css_node_style_cache_lookup (parent->cache,
@@ -325,7 +351,12 @@ lookup_in_global_parent_cache (GtkCssNode                  *node,
                                                  gtk_css_node_is_first_child (node),
                                                  gtk_css_node_is_last_child (node));
   if (node->cache == NULL)
-    return NULL;
+    {
+      node_stats.cache_misses++;
+      return NULL;
+    }
+
+  node_stats.cache_hits++;
 
   return gtk_css_node_style_cache_get_style (node->cache);
 }
@@ -371,6 +402,7 @@ gtk_css_node_create_style (GtkCssNode                   *cssnode,
     return g_object_ref (style);
 
   created_styles++;
+  node_stats.created_styles++;
 
   if (change & GTK_CSS_CHANGE_NEEDS_RECOMPUTE)
     {
@@ -446,6 +478,8 @@ gtk_css_node_real_update_style (GtkCssNode                   *cssnode,
   else if (static_style != style && (change & GTK_CSS_CHANGE_TIMESTAMP))
     {
       GtkCssNode *parent = gtk_css_node_get_parent (cssnode);
+      advanced_styles++;
+      node_stats.advanced_styles++;
       new_style = gtk_css_animated_style_new_advance (GTK_CSS_ANIMATED_STYLE (style),
                                                       static_style,
                                                       parent ? gtk_css_node_get_style (parent) : NULL,
@@ -608,6 +642,7 @@ gtk_css_node_class_init (GtkCssNodeClass *klass)
     {
       invalidated_nodes_counter = gdk_profiler_define_int_counter ("invalidated-nodes", "CSS Node Invalidations");
       created_styles_counter = gdk_profiler_define_int_counter ("created-styles", "CSS Style Creations");
+      advanced_styles_counter = gdk_profiler_define_int_counter ("advanced-styles", "CSS Animated Style Advances");
     }
 }
 
@@ -1081,12 +1116,108 @@ gtk_css_node_get_visible (GtkCssNode *cssnode)
   return cssnode->visible;
 }
 
+static void gtk_css_node_record_trigger (GtkCssNode *cssnode,
+                                         const char *format,
+                                         ...) G_GNUC_PRINTF (2, 3);
+
+/* Records a change to a node's declaration that causes a restyle,
+ * so that it can be shown in sysprof and the inspector.
+ */
+static void
+gtk_css_node_record_trigger (GtkCssNode *cssnode,
+                             const char *format,
+                             ...)
+{
+  const char *name;
+  char *change, *description;
+  va_list args;
+
+  if (!record_stats && !GDK_PROFILER_IS_RUNNING)
+    return;
+
+  va_start (args, format);
+  change = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  name = g_quark_to_string (gtk_css_node_get_name (cssnode));
+  description = g_strdup_printf ("%s: %s", name ? name : "*", change);
+  g_free (change);
+
+  if (GDK_PROFILER_IS_RUNNING)
+    gdk_profiler_add_mark (GDK_PROFILER_CURRENT_TIME, 0, "CSS change", description);
+
+  if (record_stats)
+    {
+      guint count;
+
+      if (pending_triggers == NULL)
+        pending_triggers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+      if (g_hash_table_size (pending_triggers) >= MAX_TRIGGER_STATS &&
+          !g_hash_table_contains (pending_triggers, description))
+        {
+          g_free (description);
+          description = g_strdup (OTHER_TRIGGERS);
+        }
+
+      count = GPOINTER_TO_UINT (g_hash_table_lookup (pending_triggers, description));
+      g_hash_table_replace (pending_triggers, description, GUINT_TO_POINTER (count + 1));
+    }
+  else
+    {
+      g_free (description);
+    }
+}
+
+/* Attributes the styles computed in a validation to all the
+ * triggers that happened since the last one. Triggers that happened
+ * in other toplevels get attributed to whichever validates first.
+ */
+static void
+gtk_css_node_flush_triggers (guint64 n_restyled)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+
+  if (pending_triggers == NULL || g_hash_table_size (pending_triggers) == 0)
+    return;
+
+  if (trigger_stats == NULL)
+    trigger_stats = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           NULL, (GDestroyNotify) gtk_css_node_trigger_stats_free);
+
+  g_hash_table_iter_init (&iter, pending_triggers);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GtkCssNodeTriggerStats *stats;
+
+      stats = g_hash_table_lookup (trigger_stats, key);
+      if (stats == NULL && g_hash_table_size (trigger_stats) >= MAX_TRIGGER_STATS)
+        {
+          key = (gpointer) OTHER_TRIGGERS;
+          stats = g_hash_table_lookup (trigger_stats, key);
+        }
+      if (stats == NULL)
+        {
+          stats = g_new0 (GtkCssNodeTriggerStats, 1);
+          stats->description = g_strdup (key);
+          g_hash_table_insert (trigger_stats, stats->description, stats);
+        }
+
+      stats->n_triggers += GPOINTER_TO_UINT (value);
+      stats->n_restyled += n_restyled;
+    }
+
+  g_hash_table_remove_all (pending_triggers);
+}
+
 void
 gtk_css_node_set_name (GtkCssNode *cssnode,
                        GQuark      name)
 {
   if (gtk_css_node_declaration_set_name (&cssnode->decl, name))
     {
+      gtk_css_node_record_trigger (cssnode, "name %s", g_quark_to_string (name));
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_NAME);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_NAME]);
     }
@@ -1104,6 +1235,7 @@ gtk_css_node_set_id (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_set_id (&cssnode->decl, id))
     {
+      gtk_css_node_record_trigger (cssnode, "#%s", id ? g_quark_to_string (id) : "");
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_ID);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_ID]);
     }
@@ -1142,6 +1274,13 @@ gtk_css_node_set_state (GtkCssNode    *cssnode,
                      GTK_STATE_FLAG_SELECTED))
         change |= GTK_CSS_CHANGE_STATE;
 
+      if (record_stats || GDK_PROFILER_IS_RUNNING)
+        {
+          char *str = gtk_css_change_to_string (change);
+          gtk_css_node_record_trigger (cssnode, ":%s", str);
+          g_free (str);
+        }
+
       gtk_css_node_invalidate (cssnode, change);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_STATE]);
     }
@@ -1158,6 +1297,7 @@ gtk_css_node_clear_classes (GtkCssNode *cssnode)
 {
   if (gtk_css_node_declaration_clear_classes (&cssnode->decl))
     {
+      gtk_css_node_record_trigger (cssnode, "-.*");
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1209,6 +1349,7 @@ gtk_css_node_add_class (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_add_class (&cssnode->decl, style_class))
     {
+      gtk_css_node_record_trigger (cssnode, "+.%s", g_quark_to_string (style_class));
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1220,6 +1361,7 @@ gtk_css_node_remove_class (GtkCssNode *cssnode,
 {
   if (gtk_css_node_declaration_remove_class (&cssnode->decl, style_class))
     {
+      gtk_css_node_record_trigger (cssnode, "-.%s", g_quark_to_string (style_class));
       gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_CLASS);
       g_object_notify_by_pspec (G_OBJECT (cssnode), cssnode_properties[PROP_CLASSES]);
     }
@@ -1261,6 +1403,28 @@ gtk_css_node_invalidate_style_provider (GtkCssNode *cssnode)
     }
 }
 
+/* Only some rules of the style provider changed. The provider only
+ * knows which ones while it emits the change, so we ask it about
+ * every node right away and only invalidate the affected ones.
+ * Children of those get restyled with their parent as usual.
+ */
+void
+gtk_css_node_invalidate_style_rules (GtkCssNode *cssnode)
+{
+  GtkCssNode *child;
+
+  if (gtk_style_provider_rules_changed_for_node (gtk_css_node_get_style_provider (cssnode), cssnode))
+    gtk_css_node_invalidate (cssnode, GTK_CSS_CHANGE_SOURCE);
+
+  for (child = cssnode->first_child;
+       child;
+       child = child->next_sibling)
+    {
+      if (gtk_css_node_get_style_provider_or_null (child) == NULL)
+        gtk_css_node_invalidate_style_rules (child);
+    }
+}
+
 static void
 gtk_css_node_invalidate_timestamp (GtkCssNode *cssnode)
 {
@@ -1355,8 +1519,10 @@ gtk_css_node_validate (GtkCssNode *cssnode)
   GtkCountingBloomFilter filter = GTK_COUNTING_BLOOM_FILTER_INIT;
   gint64 timestamp;
   gint64 before G_GNUC_UNUSED;
+  guint64 created_before;
 
   before = GDK_PROFILER_CURRENT_TIME;
+  created_before = node_stats.created_styles;
 
   g_assert (cssnode->parent == NULL);
 
@@ -1364,13 +1530,21 @@ gtk_css_node_validate (GtkCssNode *cssnode)
 
   gtk_css_node_validate_internal (cssnode, &filter, timestamp);
 
+  node_stats.validations++;
+  if (record_stats)
+    gtk_css_node_flush_triggers (node_stats.created_styles - created_before);
+
   if (GDK_PROFILER_IS_RUNNING)
     {
-      gdk_profiler_end_mark (before,  "Validate CSS", "");
+      gdk_profiler_end_markf (before, "Validate CSS",
+                              "%d invalidated nodes, %d created styles",
+                              invalidated_nodes, created_styles);
       gdk_profiler_set_int_counter (invalidated_nodes_counter, invalidated_nodes);
       gdk_profiler_set_int_counter (created_styles_counter, created_styles);
+      gdk_profiler_set_int_counter (advanced_styles_counter, advanced_styles);
       invalidated_nodes = 0;
       created_styles = 0;
+      advanced_styles = 0;
     }
 }
 
@@ -1457,3 +1631,89 @@ gtk_css_node_observe_children (GtkCssNode *cssnode)
   return G_LIST_MODEL (cssnode->children_observer);
 }
 
+
+void
+gtk_css_node_set_record_stats (gboolean record)
+{
+  record_stats = record;
+
+  if (!record && pending_triggers)
+    g_hash_table_remove_all (pending_triggers);
+}
+
+gboolean
+gtk_css_node_get_record_stats (void)
+{
+  return record_stats;
+}
+
+void
+gtk_css_node_get_stats (GtkCssNodeStats *stats)
+{
+  *stats = node_stats;
+}
+
+void
+gtk_css_node_trigger_stats_free (GtkCssNodeTriggerStats *stats)
+{
+  g_free (stats->description);
+  g_free (stats);
+}
+
+static int
+compare_trigger_stats (gconstpointer a,
+                       gconstpointer b)
+{
+  const GtkCssNodeTriggerStats *sa = *(const GtkCssNodeTriggerStats **) a;
+  const GtkCssNodeTriggerStats *sb = *(const GtkCssNodeTriggerStats **) b;
+
+  if (sa->n_restyled != sb->n_restyled)
+    return sa->n_restyled < sb->n_restyled ? 1 : -1;
+
+  return strcmp (sa->description, sb->description);
+}
+
+/* Returns a copy of the recorded triggers, sorted by the number
+ * of styles they caused to be computed.
+ */
+GPtrArray *
+gtk_css_node_get_trigger_stats (void)
+{
+  GPtrArray *result;
+  GHashTableIter iter;
+  gpointer value;
+
+  result = g_ptr_array_new_with_free_func ((GDestroyNotify) gtk_css_node_trigger_stats_free);
+
+  if (trigger_stats == NULL)
+    return result;
+
+  g_hash_table_iter_init (&iter, trigger_stats);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      GtkCssNodeTriggerStats *stats = value;
+      GtkCssNodeTriggerStats *copy;
+
+      copy = g_new (GtkCssNodeTriggerStats, 1);
+      copy->description = g_strdup (stats->description);
+      copy->n_triggers = stats->n_triggers;
+      copy->n_restyled = stats->n_restyled;
+
+      g_ptr_array_add (result, copy);
+    }
+
+  g_ptr_array_sort (result, compare_trigger_stats);
+
+  return result;
+}
+
+void
+gtk_css_node_reset_stats (void)
+{
+  memset (&node_stats, 0, sizeof (GtkCssNodeStats));
+
+  if (trigger_stats)
+    g_hash_table_remove_all (trigger_stats);
+  if (pending_triggers)
+    g_hash_table_remove_all (pending_triggers);
+}
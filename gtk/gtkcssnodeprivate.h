@@ -144,6 +144,8 @@ GtkCssStyle *           gtk_css_node_get_style          (GtkCssNode            *
 
 void                    gtk_css_node_invalidate_style_provider
                                                         (GtkCssNode            *cssnode);
+void                    gtk_css_node_invalidate_style_rules
+                                                        (GtkCssNode            *cssnode);
 void                    gtk_css_node_invalidate_frame_clock
                                                         (GtkCssNode            *cssnode,
                                                          gboolean               just_timestamp);
@@ -167,5 +169,32 @@ void                    gtk_css_node_print              (GtkCssNode           *c
 
 GListModel *            gtk_css_node_observe_children   (GtkCssNode                *cssnode);
 
+typedef struct _GtkCssNodeStats GtkCssNodeStats;
+typedef struct _GtkCssNodeTriggerStats GtkCssNodeTriggerStats;
+
+struct _GtkCssNodeStats
+{
+  guint64 validations;          /* number of calls to gtk_css_node_validate() */
+  guint64 invalidated_nodes;    /* nodes marked as needing validation */
+  guint64 created_styles;       /* static styles computed from scratch */
+  guint64 advanced_styles;      /* animated styles advanced to a new frame */
+  guint64 cache_hits;           /* styles found in the parent's style cache */
+  guint64 cache_misses;         /* cache lookups that had to compute a style */
+};
+
+struct _GtkCssNodeTriggerStats
+{
+  char    *description;         /* e.g. "button: +.suggested-action" */
+  guint    n_triggers;          /* how often this change happened */
+  guint64  n_restyled;          /* styles computed in the validations it caused */
+};
+
+void                    gtk_css_node_set_record_stats   (gboolean                   record);
+gboolean                gtk_css_node_get_record_stats   (void);
+void                    gtk_css_node_get_stats          (GtkCssNodeStats           *stats);
+GPtrArray *             gtk_css_node_get_trigger_stats  (void);
+void                    gtk_css_node_reset_stats        (void);
+void                    gtk_css_node_trigger_stats_free (GtkCssNodeTriggerStats    *stats);
+
 G_END_DECLS
 
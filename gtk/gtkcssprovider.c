@@ -27,6 +27,7 @@
 #include "gtkcssarrayvalueprivate.h"
 #include "gtkcsscolorvalueprivate.h"
 #include "gtkcsscustompropertypoolprivate.h"
+#include "gtkcssimagecacheprivate.h"
 #include "gtkcsskeyframesprivate.h"
 #include "gtkcssreferencevalueprivate.h"
 #include "gtkcssselectorprivate.h"
@@ -138,6 +139,8 @@ struct _GtkCssProviderPrivate
 
   GArray *rulesets;
   GtkCssSelectorTree *tree;
+  GtkCssSelectorTree *changed_rules; /* rules changed by a reload, while emitting */
+  GHashTable *image_files; /* image files referenced by the rules */
   GResource *resource;
   char *path;
   GBytes *bytes; /* *no* reference */
@@ -163,6 +166,12 @@ gtk_css_provider_load_internal (GtkCssProvider *css_provider,
                                 GtkCssScanner  *scanner,
                                 GFile          *file,
                                 GBytes         *bytes);
+static void gtk_css_ruleset_print (const GtkCssRuleset *ruleset,
+                                   GString             *str);
+static void gtk_css_provider_print_colors (GHashTable *colors,
+                                           GString    *str);
+static void gtk_css_provider_print_keyframes (GHashTable *keyframes,
+                                              GString    *str);
 
 G_DEFINE_TYPE_EXTENDED (GtkCssProvider, gtk_css_provider, G_TYPE_OBJECT, 0,
                         G_ADD_PRIVATE (GtkCssProvider)
@@ -448,6 +457,7 @@ gtk_css_provider_init (GtkCssProvider *css_provider)
   GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
 
   priv->rulesets = g_array_new (FALSE, FALSE, sizeof (GtkCssRuleset));
+  priv->image_files = g_hash_table_new_full ((GHashFunc) g_file_hash, (GEqualFunc) g_file_equal, g_object_unref, NULL);
 
   priv->symbolic_colors = g_hash_table_new_full (g_str_hash, g_str_equal,
                                                  (GDestroyNotify) g_free,
@@ -578,6 +588,30 @@ gtk_css_style_provider_lookup (GtkStyleProvider             *provider,
     *change = gtk_css_selector_tree_get_change_all (priv->tree, filter, node);
 }
 
+static gboolean
+gtk_css_style_provider_rules_changed_for_node (GtkStyleProvider *provider,
+                                               GtkCssNode       *node)
+{
+  GtkCssProvider *css_provider = GTK_CSS_PROVIDER (provider);
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
+  GtkCssSelectorMatches tree_rules;
+  gboolean matches;
+
+  if (priv->changed_rules == NULL)
+    return FALSE;
+
+  /* The rule may apply to the node if the node changes state */
+  if (gtk_css_selector_tree_get_change_all (priv->changed_rules, NULL, node))
+    return TRUE;
+
+  gtk_css_selector_matches_init (&tree_rules);
+  _gtk_css_selector_tree_match_all (priv->changed_rules, NULL, node, &tree_rules);
+  matches = !gtk_css_selector_matches_is_empty (&tree_rules);
+  gtk_css_selector_matches_clear (&tree_rules);
+
+  return matches;
+}
+
 static gboolean
 gtk_css_style_provider_has_section (GtkStyleProvider *provider,
                                     GtkCssSection    *section)
@@ -596,6 +630,7 @@ gtk_css_style_provider_iface_init (GtkStyleProviderInterface *iface)
   iface->lookup = gtk_css_style_provider_lookup;
   iface->emit_error = gtk_css_style_provider_emit_error;
   iface->has_section = gtk_css_style_provider_has_section;
+  iface->rules_changed_for_node = gtk_css_style_provider_rules_changed_for_node;
 }
 
 static void
@@ -610,6 +645,7 @@ gtk_css_provider_finalize (GObject *object)
 
   g_array_free (priv->rulesets, TRUE);
   _gtk_css_selector_tree_free (priv->tree);
+  g_hash_table_unref (priv->image_files);
 
   g_hash_table_destroy (priv->symbolic_colors);
   g_hash_table_destroy (priv->keyframes);
@@ -687,6 +723,10 @@ gtk_css_provider_reset (GtkCssProvider *css_provider)
   g_hash_table_remove_all (priv->symbolic_colors);
   g_hash_table_remove_all (priv->keyframes);
 
+  /* Make sure reloading picks up changed image files */
+  gtk_css_image_cache_remove_files (priv->image_files);
+  g_hash_table_remove_all (priv->image_files);
+
   for (i = 0; i < priv->rulesets->len; i++)
     gtk_css_ruleset_clear (&g_array_index (priv->rulesets, GtkCssRuleset, i));
   g_array_set_size (priv->rulesets, 0);
@@ -1249,13 +1289,16 @@ gtk_css_provider_load_internal (GtkCssProvider *self,
   if (bytes)
     {
       GtkCssScanner *scanner;
+      GHashTable *tracked_files;
 
       scanner = gtk_css_scanner_new (self,
                                      parent,
                                      file,
                                      bytes);
 
+      tracked_files = gtk_css_image_cache_track_files (priv->image_files);
       parse_stylesheet (scanner);
+      gtk_css_image_cache_track_files (tracked_files);
 
       gtk_css_scanner_destroy (scanner);
 
@@ -1273,6 +1316,392 @@ gtk_css_provider_load_internal (GtkCssProvider *self,
     }
 }
 
+/* Reloads with more changed rules than this restyle everything */
+#define MAX_CHANGED_RULES 64
+/* Sheets with more rules than this are not diffed at all */
+#define MAX_DIFFED_RULES (MAX_CHANGED_RULES * 4)
+
+static GPtrArray *
+gtk_css_provider_print_rules (GtkCssProvider *self)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (self);
+  GPtrArray *rules;
+  GString *str;
+  guint i;
+
+  rules = g_ptr_array_new_full (priv->rulesets->len, g_free);
+  str = g_string_new (NULL);
+
+  for (i = 0; i < priv->rulesets->len; i++)
+    {
+      g_string_truncate (str, 0);
+      gtk_css_ruleset_print (&g_array_index (priv->rulesets, GtkCssRuleset, i), str);
+      g_ptr_array_add (rules, g_strndup (str->str, str->len));
+    }
+
+  g_string_free (str, TRUE);
+
+  return rules;
+}
+
+static char *
+gtk_css_provider_print_globals (GtkCssProvider *self)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (self);
+  GString *str;
+
+  str = g_string_new (NULL);
+  gtk_css_provider_print_colors (priv->symbolic_colors, str);
+  gtk_css_provider_print_keyframes (priv->keyframes, str);
+
+  return g_string_free (str, FALSE);
+}
+
+/* Greedily matches every rule in @from with the next equal rule in @to.
+ * The matched rules form a common subsequence of both arrays.
+ */
+static guint
+match_rules_in_order (char     **from,
+                      guint      n_from,
+                      char     **to,
+                      guint      n_to,
+                      gboolean  *from_matched,
+                      gboolean  *to_matched)
+{
+  GHashTable *first;
+  int *next;
+  int last = -1;
+  guint i, n_matched = 0;
+
+  first = g_hash_table_new (g_str_hash, g_str_equal);
+  next = g_new (int, n_to);
+
+  for (i = n_to; i-- > 0; )
+    {
+      gpointer pos;
+
+      if (g_hash_table_lookup_extended (first, to[i], NULL, &pos))
+        next[i] = GPOINTER_TO_INT (pos);
+      else
+        next[i] = -1;
+      g_hash_table_insert (first, to[i], GINT_TO_POINTER (i));
+    }
+
+  for (i = 0; i < n_from; i++)
+    {
+      gpointer p;
+      int pos;
+
+      if (!g_hash_table_lookup_extended (first, from[i], NULL, &p))
+        continue;
+
+      for (pos = GPOINTER_TO_INT (p); pos != -1 && pos <= last; pos = next[pos])
+        ;
+
+      if (pos == -1)
+        {
+          g_hash_table_remove (first, from[i]);
+          continue;
+        }
+
+      from_matched[i] = TRUE;
+      to_matched[pos] = TRUE;
+      last = pos;
+      n_matched++;
+
+      if (next[pos] != -1)
+        g_hash_table_insert (first, from[i], GINT_TO_POINTER (next[pos]));
+      else
+        g_hash_table_remove (first, from[i]);
+    }
+
+  g_free (next);
+  g_hash_table_unref (first);
+
+  return n_matched;
+}
+
+static void
+add_changed_selectors (GHashTable  *selectors,
+                       char       **rules,
+                       guint        n_rules,
+                       gboolean    *matched)
+{
+  guint i;
+
+  for (i = 0; i < n_rules; i++)
+    {
+      const char *end;
+
+      if (matched[i])
+        continue;
+
+      /* Selectors never contain braces */
+      end = strstr (rules[i], " {\n");
+      g_hash_table_add (selectors, g_strndup (rules[i], end - rules[i]));
+    }
+}
+
+/* Finds the selectors of the rules that were added, removed, modified
+ * or reordered. Nodes that match none of them end up with the same
+ * rules in the same order, so their style can't have changed.
+ *
+ * Returns %NULL if there are too many changes to bother.
+ */
+static GHashTable *
+gtk_css_provider_diff_rules (GPtrArray *old_rules,
+                             GPtrArray *new_rules)
+{
+  char **old = (char **) old_rules->pdata;
+  char **new = (char **) new_rules->pdata;
+  guint n_old = old_rules->len;
+  guint n_new = new_rules->len;
+  gboolean *old_matched, *new_matched;
+  gboolean *old_matched2, *new_matched2;
+  GHashTable *selectors;
+  guint start, n_matched, n_matched2;
+
+  /* Edits usually leave most of the sorted rules alone */
+  for (start = 0; start < n_old && start < n_new; start++)
+    {
+      if (!g_str_equal (old[start], new[start]))
+        break;
+    }
+  old += start;
+  new += start;
+  n_old -= start;
+  n_new -= start;
+
+  while (n_old > 0 && n_new > 0 && g_str_equal (old[n_old - 1], new[n_new - 1]))
+    {
+      n_old--;
+      n_new--;
+    }
+
+  if (n_old > MAX_DIFFED_RULES || n_new > MAX_DIFFED_RULES)
+    return NULL;
+
+  old_matched = g_new0 (gboolean, n_old);
+  new_matched = g_new0 (gboolean, n_new);
+  old_matched2 = g_new0 (gboolean, n_old);
+  new_matched2 = g_new0 (gboolean, n_new);
+
+  /* Matching greedily from either side catches rules that moved
+   * forwards as well as rules that moved backwards.
+   */
+  n_matched = match_rules_in_order (old, n_old, new, n_new, old_matched, new_matched);
+  n_matched2 = match_rules_in_order (new, n_new, old, n_old, new_matched2, old_matched2);
+  if (n_matched2 > n_matched)
+    {
+      g_free (old_matched);
+      g_free (new_matched);
+      old_matched = old_matched2;
+      new_matched = new_matched2;
+      n_matched = n_matched2;
+    }
+  else
+    {
+      g_free (old_matched2);
+      g_free (new_matched2);
+    }
+
+  if (n_old + n_new - 2 * n_matched > MAX_CHANGED_RULES)
+    {
+      selectors = NULL;
+    }
+  else
+    {
+      selectors = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+      add_changed_selectors (selectors, old, n_old, old_matched);
+      add_changed_selectors (selectors, new, n_new, new_matched);
+    }
+
+  g_free (old_matched);
+  g_free (new_matched);
+
+  return selectors;
+}
+
+static GtkCssSelectorTree *
+gtk_css_provider_build_changed_tree (GHashTable *selectors)
+{
+  GtkCssSelectorTreeBuilder *builder;
+  GtkCssSelectorTree *tree = NULL;
+  GtkCssSelectors parsed;
+  GHashTableIter iter;
+  gpointer key;
+  guint i;
+
+  builder = _gtk_css_selector_tree_builder_new ();
+  gtk_css_selectors_init (&parsed);
+
+  g_hash_table_iter_init (&iter, selectors);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      GtkCssParser *parser;
+      GtkCssSelector *selector;
+      GBytes *bytes;
+      gboolean at_end;
+
+      bytes = g_bytes_new_static (key, strlen (key));
+      parser = gtk_css_parser_new_for_bytes (bytes, NULL, NULL, NULL, NULL);
+      selector = _gtk_css_selector_parse (parser);
+      at_end = gtk_css_parser_has_token (parser, GTK_CSS_TOKEN_EOF);
+      gtk_css_parser_unref (parser);
+      g_bytes_unref (bytes);
+
+      if (selector == NULL)
+        goto out;
+
+      gtk_css_selectors_append (&parsed, selector);
+
+      if (!at_end)
+        goto out;
+
+      /* We only care whether anything matches, so any match pointer will do */
+      _gtk_css_selector_tree_builder_add (builder, selector, NULL, builder);
+    }
+
+  tree = _gtk_css_selector_tree_builder_build (builder);
+
+out:
+  _gtk_css_selector_tree_builder_free (builder);
+  for (i = 0; i < gtk_css_selectors_get_size (&parsed); i++)
+    _gtk_css_selector_free (gtk_css_selectors_get (&parsed, i));
+  gtk_css_selectors_clear (&parsed);
+
+  return tree;
+}
+
+static void
+gtk_css_provider_emit_changed (GtkCssProvider *self)
+{
+  gtk_style_provider_changed (GTK_STYLE_PROVIDER (self));
+}
+
+/* Whether the current contents of the provider can be compared
+ * with gtk_css_provider_diff_rules().
+ */
+static gboolean
+gtk_css_provider_can_diff_rules (GtkCssProvider *self)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (self);
+
+  /* Sections point into the loaded data, so keep them all up to date */
+  if (gtk_keep_css_sections)
+    return FALSE;
+
+  /* Printing a big sheet costs more than restyling, and changing
+   * themes replaces all of it anyway.
+   */
+  if (priv->rulesets->len == 0 || priv->rulesets->len > MAX_DIFFED_RULES)
+    return FALSE;
+
+  /* Reloading drops our images from the cache, so that changed files
+   * get picked up. Printed rules don't show which file an image came
+   * from, so we can't tell which styles hold on to old textures.
+   */
+  if (g_hash_table_size (priv->image_files) > 0)
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gtk_css_provider_emit_rules_changed (GtkCssProvider *self,
+                                     GPtrArray      *old_rules,
+                                     const char     *old_globals)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (self);
+  GPtrArray *new_rules;
+  char *new_globals;
+  GHashTable *selectors;
+
+  if (!gtk_css_provider_can_diff_rules (self))
+    {
+      gtk_css_provider_emit_changed (self);
+      return;
+    }
+
+  new_globals = gtk_css_provider_print_globals (self);
+  if (!g_str_equal (old_globals, new_globals))
+    {
+      g_free (new_globals);
+      gtk_css_provider_emit_changed (self);
+      return;
+    }
+  g_free (new_globals);
+
+  new_rules = gtk_css_provider_print_rules (self);
+  selectors = gtk_css_provider_diff_rules (old_rules, new_rules);
+  g_ptr_array_unref (new_rules);
+
+  if (selectors == NULL)
+    {
+      gtk_css_provider_emit_changed (self);
+      return;
+    }
+
+  if (g_hash_table_size (selectors) == 0)
+    {
+      /* Nothing changed, so no styles need updating */
+      g_hash_table_unref (selectors);
+      return;
+    }
+
+  priv->changed_rules = gtk_css_provider_build_changed_tree (selectors);
+
+  if (priv->changed_rules == NULL)
+    {
+      g_hash_table_unref (selectors);
+      gtk_css_provider_emit_changed (self);
+      return;
+    }
+
+  gdk_profiler_add_markf (GDK_PROFILER_CURRENT_TIME, 0, "CSS rules changed",
+                          "%u selectors", g_hash_table_size (selectors));
+  g_hash_table_unref (selectors);
+
+  /* Handlers invalidate the affected nodes right away, so the
+   * changed rules aren't needed after this.
+   */
+  gtk_style_provider_rules_changed (GTK_STYLE_PROVIDER (self));
+
+  g_clear_pointer (&priv->changed_rules, _gtk_css_selector_tree_free);
+}
+
+/* Replaces the contents of the provider. If it had rules before, we
+ * compare old and new rules, so that nodes the changed rules can't
+ * apply to don't need to be restyled.
+ */
+static void
+gtk_css_provider_reload (GtkCssProvider *self,
+                         GFile          *file,
+                         GBytes         *bytes)
+{
+  GPtrArray *old_rules;
+  char *old_globals;
+
+  if (!gtk_css_provider_can_diff_rules (self))
+    {
+      gtk_css_provider_reset (self);
+      gtk_css_provider_load_internal (self, NULL, file, bytes);
+      gtk_css_provider_emit_changed (self);
+      return;
+    }
+
+  old_rules = gtk_css_provider_print_rules (self);
+  old_globals = gtk_css_provider_print_globals (self);
+
+  gtk_css_provider_reset (self);
+  gtk_css_provider_load_internal (self, NULL, file, bytes);
+
+  gtk_css_provider_emit_rules_changed (self, old_rules, old_globals);
+
+  g_ptr_array_unref (old_rules);
+  g_free (old_globals);
+}
+
 /**
  * gtk_css_provider_load_from_data:
  * @css_provider: a `GtkCssProvider`
@@ -1351,11 +1780,7 @@ gtk_css_provider_load_from_bytes (GtkCssProvider *css_provider,
   g_return_if_fail (GTK_IS_CSS_PROVIDER (css_provider));
   g_return_if_fail (data != NULL);
 
-  gtk_css_provider_reset (css_provider);
-
-  gtk_css_provider_load_internal (css_provider, NULL, NULL, g_bytes_ref (data));
-
-  gtk_style_provider_changed (GTK_STYLE_PROVIDER (css_provider));
+  gtk_css_provider_reload (css_provider, NULL, g_bytes_ref (data));
 }
 
 /**
@@ -1374,11 +1799,7 @@ gtk_css_provider_load_from_file (GtkCssProvider  *css_provider,
   g_return_if_fail (GTK_IS_CSS_PROVIDER (css_provider));
   g_return_if_fail (G_IS_FILE (file));
 
-  gtk_css_provider_reset (css_provider);
-
-  gtk_css_provider_load_internal (css_provider, NULL, file, NULL);
-
-  gtk_style_provider_changed (GTK_STYLE_PROVIDER (css_provider));
+  gtk_css_provider_reload (css_provider, file, NULL);
 }
 
 /**
@@ -324,6 +324,14 @@ struct _GtkLabel
   int      width_chars;
   int      max_width_chars;
   int      lines;
+
+  /* Size of the layout when it is not wrapped, valid while
+   * unwrapped_serial matches the serial of the pango context
+   */
+  guint    unwrapped_serial;
+  int      unwrapped_width;
+  int      unwrapped_height;
+  int      unwrapped_baseline;
 };
 
 struct _GtkLabelClass
@@ -912,6 +920,7 @@ gtk_label_update_layout_attributes (GtkLabel      *self,
   attrs = _gtk_pango_attr_list_merge (attrs, self->attrs);
 
   pango_layout_set_attributes (self->layout, attrs);
+  self->unwrapped_serial = 0;
 
   pango_attr_list_unref (attrs);
 }
@@ -1188,6 +1197,53 @@ get_static_size (GtkLabel       *self,
   g_object_unref (layout);
 }
 
+static void
+gtk_label_ensure_unwrapped_size (GtkLabel *self)
+{
+  PangoLayout *layout;
+  guint serial;
+
+  gtk_label_ensure_layout (self);
+
+  serial = pango_context_get_serial (pango_layout_get_context (self->layout));
+  if (self->unwrapped_serial == serial)
+    return;
+
+  layout = gtk_label_get_measuring_layout (self, NULL, -1);
+  pango_layout_get_size (layout, &self->unwrapped_width, &self->unwrapped_height);
+  self->unwrapped_baseline = pango_layout_get_baseline (layout);
+  g_object_unref (layout);
+
+  self->unwrapped_serial = serial;
+}
+
+static void
+get_height_at_width (GtkLabel *self,
+                     int       width,
+                     int      *height,
+                     int      *baseline)
+{
+  PangoLayout *layout;
+
+  /* Height-for-width is asked for many widths, and most of them
+   * are wide enough for the text to not wrap at all. Those all
+   * have the same height, so avoid laying out the text again.
+   */
+  gtk_label_ensure_unwrapped_size (self);
+
+  if (width < 0 || width >= self->unwrapped_width)
+    {
+      *height = self->unwrapped_height;
+      *baseline = self->unwrapped_baseline;
+      return;
+    }
+
+  layout = gtk_label_get_measuring_layout (self, NULL, width);
+  pango_layout_get_size (layout, NULL, height);
+  *baseline = pango_layout_get_baseline (layout);
+  g_object_unref (layout);
+}
+
 static void
 get_height_for_width (GtkLabel *self,
                       int       width,
@@ -1196,41 +1252,25 @@ get_height_for_width (GtkLabel *self,
                       int      *minimum_baseline,
                       int      *natural_baseline)
 {
-  PangoLayout *layout;
-  int natural_width, text_height, baseline;
+  int natural_width;
 
   if (width < 0)
     {
       /* Minimum height is assuming infinite width */
-      layout = gtk_label_get_measuring_layout (self, NULL, -1);
-      pango_layout_get_size (layout, NULL, minimum_height);
-      baseline = pango_layout_get_baseline (layout);
-      *minimum_baseline = baseline;
+      get_height_at_width (self, -1, minimum_height, minimum_baseline);
 
       /* Natural height is assuming natural width */
       get_default_widths (self, NULL, &natural_width);
-
-      layout = gtk_label_get_measuring_layout (self, layout, natural_width);
-      pango_layout_get_size (layout, NULL, natural_height);
-      baseline = pango_layout_get_baseline (layout);
-      *natural_baseline = baseline;
+      get_height_at_width (self, natural_width, natural_height, natural_baseline);
     }
   else
     {
       /* minimum = natural for any given width */
-      layout = gtk_label_get_measuring_layout (self, NULL, width);
-
-      pango_layout_get_size (layout, NULL, &text_height);
+      get_height_at_width (self, width, minimum_height, minimum_baseline);
 
-      *minimum_height = text_height;
-      *natural_height = text_height;
-
-      baseline = pango_layout_get_baseline (layout);
-      *minimum_baseline = baseline;
-      *natural_baseline = baseline;
+      *natural_height = *minimum_height;
+      *natural_baseline = *minimum_baseline;
     }
-
-  g_object_unref (layout);
 }
 
 static int
@@ -4334,6 +4374,7 @@ static void
 gtk_label_clear_layout (GtkLabel *self)
 {
   g_clear_object (&self->layout);
+  self->unwrapped_serial = 0;
 }
 
 static void
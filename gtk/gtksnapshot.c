@@ -2413,10 +2413,10 @@ gtk_snapshot_append_text (GtkSnapshot           *snapshot,
 
   gtk_snapshot_ensure_translate (snapshot, &dx, &dy);
 
-  node = gsk_text_node_new (font,
-                            glyphs,
-                            color,
-                            &GRAPHENE_POINT_INIT (x + dx, y + dy));
+  node = gsk_pango_text_node_get (font,
+                                  glyphs,
+                                  color,
+                                  &GRAPHENE_POINT_INIT (x + dx, y + dy));
   if (node == NULL)
     return;
 
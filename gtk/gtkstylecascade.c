@@ -208,6 +208,33 @@ gtk_style_cascade_lookup (GtkStyleProvider             *provider,
   gtk_style_cascade_iter_clear (&iter);
 }
 
+static gboolean
+gtk_style_cascade_rules_changed_for_node (GtkStyleProvider *provider,
+                                          GtkCssNode       *node)
+{
+  GtkStyleCascade *cascade = GTK_STYLE_CASCADE (provider);
+  GtkStyleCascadeIter iter;
+  GtkStyleProvider *item;
+
+  for (item = gtk_style_cascade_iter_init (cascade, &iter);
+       item;
+       item = gtk_style_cascade_iter_next (cascade, &iter))
+    {
+      GtkStyleProviderInterface *iface = GTK_STYLE_PROVIDER_GET_INTERFACE (item);
+
+      /* Providers that can't tell never emit rules changes */
+      if (iface->rules_changed_for_node &&
+          iface->rules_changed_for_node (item, node))
+        {
+          gtk_style_cascade_iter_clear (&iter);
+          return TRUE;
+        }
+    }
+
+  gtk_style_cascade_iter_clear (&iter);
+  return FALSE;
+}
+
 static void
 gtk_style_cascade_emit_error (GtkStyleProvider *provider,
                               GtkCssSection    *section,
@@ -240,6 +267,7 @@ gtk_style_cascade_provider_iface_init (GtkStyleProviderInterface *iface)
   iface->get_keyframes = gtk_style_cascade_get_keyframes;
   iface->lookup = gtk_style_cascade_lookup;
   iface->emit_error = gtk_style_cascade_emit_error;
+  iface->rules_changed_for_node = gtk_style_cascade_rules_changed_for_node;
 }
 
 G_DEFINE_TYPE_EXTENDED (GtkStyleCascade, _gtk_style_cascade, G_TYPE_OBJECT, 0,
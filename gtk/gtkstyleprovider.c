@@ -44,6 +44,7 @@ enum {
 G_DEFINE_INTERFACE (GtkStyleProvider, gtk_style_provider, G_TYPE_OBJECT)
 
 static guint signals[LAST_SIGNAL];
+static guint rules_change_depth;
 
 static void
 gtk_style_provider_default_init (GtkStyleProviderInterface *iface)
@@ -127,6 +128,47 @@ gtk_style_provider_changed (GtkStyleProvider *provider)
   g_signal_emit (provider, signals[CHANGED], 0);
 }
 
+/* Like gtk_style_provider_changed(), but tells handlers that only
+ * the rules of the provider changed. Nodes then only need a new
+ * style if gtk_style_provider_rules_changed_for_node() says so.
+ * That can only be asked during the emission.
+ */
+void
+gtk_style_provider_rules_changed (GtkStyleProvider *provider)
+{
+  gtk_internal_return_if_fail (GTK_IS_STYLE_PROVIDER (provider));
+
+  rules_change_depth++;
+  g_signal_emit (provider, signals[CHANGED], 0);
+  rules_change_depth--;
+}
+
+/* Whether the currently emitted ::gtk-private-changed signal was
+ * caused by gtk_style_provider_rules_changed(). This includes the
+ * emissions forwarded by cascades.
+ */
+gboolean
+gtk_style_provider_is_rules_change (void)
+{
+  return rules_change_depth > 0;
+}
+
+gboolean
+gtk_style_provider_rules_changed_for_node (GtkStyleProvider *provider,
+                                           GtkCssNode       *node)
+{
+  GtkStyleProviderInterface *iface;
+
+  gtk_internal_return_val_if_fail (GTK_IS_STYLE_PROVIDER (provider), TRUE);
+
+  iface = GTK_STYLE_PROVIDER_GET_INTERFACE (provider);
+
+  if (!iface->rules_changed_for_node)
+    return TRUE;
+
+  return iface->rules_changed_for_node (provider, node);
+}
+
 GtkSettings *
 gtk_style_provider_get_settings (GtkStyleProvider *provider)
 {
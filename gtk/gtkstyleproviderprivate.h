@@ -54,6 +54,8 @@ struct _GtkStyleProviderInterface
   void                  (* changed)             (GtkStyleProvider        *provider);
   gboolean              (* has_section)         (GtkStyleProvider        *provider,
                                                  GtkCssSection           *section);
+  gboolean              (* rules_changed_for_node) (GtkStyleProvider     *provider,
+                                                 GtkCssNode              *node);
 };
 
 GtkSettings *           gtk_style_provider_get_settings          (GtkStyleProvider        *provider);
@@ -69,6 +71,10 @@ void                    gtk_style_provider_lookup                (GtkStyleProvid
                                                                   GtkCssChange            *out_change);
 
 void                    gtk_style_provider_changed               (GtkStyleProvider        *provider);
+void                    gtk_style_provider_rules_changed         (GtkStyleProvider        *provider);
+gboolean                gtk_style_provider_is_rules_change       (void);
+gboolean                gtk_style_provider_rules_changed_for_node (GtkStyleProvider       *provider,
+                                                                  GtkCssNode              *node);
 
 void                    gtk_style_provider_emit_error            (GtkStyleProvider        *provider,
                                                                   GtkCssSection           *section,
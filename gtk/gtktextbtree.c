@@ -163,6 +163,8 @@ struct _BTreeView {
   GtkTextLayout *layout;
   BTreeView *next;
   BTreeView *prev;
+  /* Height assumed for lines without line data */
+  int estimated_line_height;
 };
 
 /*
@@ -276,11 +278,11 @@ static void                  gtk_text_btree_node_invalidate_downward  (GtkTextBT
 static void                  gtk_text_btree_node_invalidate_upward    (GtkTextBTreeNode *node,
                                                                        gpointer          view_id);
 static NodeData *            gtk_text_btree_node_check_valid          (GtkTextBTreeNode *node,
-                                                                       gpointer          view_id);
+                                                                       BTreeView        *view);
 static NodeData *            gtk_text_btree_node_check_valid_downward (GtkTextBTreeNode *node,
-                                                                       gpointer          view_id);
+                                                                       BTreeView        *view);
 static void                  gtk_text_btree_node_check_valid_upward   (GtkTextBTreeNode *node,
-                                                                       gpointer          view_id);
+                                                                       BTreeView        *view);
 
 static void                  gtk_text_btree_node_remove_view         (BTreeView        *view,
                                                                       GtkTextBTreeNode *node,
@@ -346,6 +348,18 @@ chars_changed (GtkTextBTree *tree)
   tree->chars_changed_stamp += 1;
 }
 
+/* Lines that have not been laid out yet are assumed to have the
+ * estimated line height of the view, so that the total height (and
+ * with it the scrollbars) is roughly right before the whole buffer
+ * has been validated.
+ */
+static inline int
+line_data_get_height (GtkTextLineData *ld,
+                      BTreeView       *view)
+{
+  return ld ? ld->height : view->estimated_line_height;
+}
+
 /*
  * BTree operations
  */
@@ -992,10 +1006,8 @@ _gtk_text_btree_delete (GtkTextIter *start,
               ld = _gtk_text_line_get_data (line, view->view_id);
 
               if (ld)
-                {
-                  deleted_width = MAX (deleted_width, ld->width);
-                  deleted_height += ld->height;
-                }
+                deleted_width = MAX (deleted_width, ld->width);
+              deleted_height += line_data_get_height (ld, view);
 
               line = next_line;
             }
@@ -1009,12 +1021,13 @@ _gtk_text_btree_delete (GtkTextIter *start,
                   /* This means that start_line has never been validated.
                    * We don't really want to do the validation here but
                    * we do need to store our temporary sizes. So we
-                   * create the line data and assume a line w/h of 0.
+                   * create the line data and assume a width of 0 and
+                   * the estimated line height.
                    */
                   ld = _gtk_text_line_data_new (view->layout, start_line);
                   _gtk_text_line_add_data (start_line, ld);
                   ld->width = 0;
-                  ld->height = 0;
+                  ld->height = view->estimated_line_height;
                   ld->valid = FALSE;
                 }
 
@@ -1023,9 +1036,9 @@ _gtk_text_btree_delete (GtkTextIter *start,
               ld->valid = FALSE;
             }
 
-          gtk_text_btree_node_check_valid_downward (ancestor_node, view->view_id);
+          gtk_text_btree_node_check_valid_downward (ancestor_node, view);
           if (ancestor_node->parent)
-            gtk_text_btree_node_check_valid_upward (ancestor_node->parent, view->view_id);
+            gtk_text_btree_node_check_valid_upward (ancestor_node->parent, view);
 
           view = view->next;
         }
@@ -1100,8 +1113,12 @@ _gtk_text_btree_insert (GtkTextIter *iter,
                                         */
 
   int char_count_delta;                /* change to number of chars */
+  int last_sol;                        /* start of the text that ends up
+                                        * on the last line
+                                        */
   GtkTextBTree *tree;
   int start_byte_index;
+  int end_byte_index;
   GtkTextLine *start_line;
 
   g_return_if_fail (text != NULL);
@@ -1137,6 +1154,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
 
   eol = 0;
   sol = 0;
+  last_sol = 0;
   line_count_delta = 0;
   char_count_delta = 0;
   while (eol < len)
@@ -1197,6 +1215,7 @@ _gtk_text_btree_insert (GtkTextIter *iter,
       line = newline;
       cur_seg = NULL;
       line_count_delta++;
+      last_sol = eol;
     }
 
   /*
@@ -1223,12 +1242,19 @@ _gtk_text_btree_insert (GtkTextIter *iter,
                                       &start,
                                       start_line,
                                       start_byte_index);
-    end = start;
 
-    /* We could almost certainly be more efficient here
-       by saving the information from the insertion loop
-       above. FIXME */
-    gtk_text_iter_forward_chars (&end, char_count_delta);
+    /* The insertion loop tells us where the text ends, so there
+     * is no need to walk over all of it to find the end iter.
+     */
+    if (line == start_line)
+      end_byte_index = start_byte_index + len;
+    else
+      end_byte_index = len - last_sol;
+
+    _gtk_text_btree_get_iter_at_line (tree,
+                                      &end,
+                                      line,
+                                      end_byte_index);
 
     DV (g_print ("invalidating due to inserting some text (%s)\n", G_STRLOC));
     _gtk_text_btree_invalidate_region (tree, &start, &end, FALSE);
@@ -1358,17 +1384,16 @@ find_line_by_y (GtkTextBTree *tree, BTreeView *view,
       while (line != NULL && line != last_line)
         {
           GtkTextLineData *ld;
+          int height;
 
           ld = _gtk_text_line_get_data (line, view->view_id);
+          height = line_data_get_height (ld, view);
 
-          if (ld)
-            {
-              if (y < (current_y + ld->height))
-                return line;
+          if (y < (current_y + height))
+            return line;
 
-              current_y += ld->height;
-              *line_top += ld->height;
-            }
+          current_y += height;
+          *line_top += height;
 
           line = line->next;
         }
@@ -1443,8 +1468,7 @@ find_line_top_in_line_list (GtkTextBTree *tree,
         return y;
 
       ld = _gtk_text_line_get_data (line, view->view_id);
-      if (ld)
-        y += ld->height;
+      y += line_data_get_height (ld, view);
 
       line = line->next;
     }
@@ -1538,6 +1562,7 @@ _gtk_text_btree_add_view (GtkTextBTree *tree,
 
   view->view_id = layout;
   view->layout = layout;
+  view->estimated_line_height = 0;
 
   view->next = tree->views;
   view->prev = NULL;
@@ -1646,6 +1671,35 @@ _gtk_text_btree_get_view_size (GtkTextBTree *tree,
                                 width, height);
 }
 
+/**
+ * _gtk_text_btree_set_estimated_line_height:
+ * @tree: a GtkTextBTree
+ * @view_id: view id
+ * @height: the height to assume for lines that have not been laid out
+ *
+ * Sets the height that lines without line data count with in the
+ * size of the view, and recomputes the size of the view.
+ */
+void
+_gtk_text_btree_set_estimated_line_height (GtkTextBTree *tree,
+                                           gpointer      view_id,
+                                           int           height)
+{
+  BTreeView *view;
+
+  g_return_if_fail (tree != NULL);
+  g_return_if_fail (view_id != NULL);
+
+  view = gtk_text_btree_get_view (tree, view_id);
+  g_return_if_fail (view != NULL);
+
+  if (view->estimated_line_height == height)
+    return;
+
+  view->estimated_line_height = height;
+  gtk_text_btree_node_check_valid_downward (tree->root_node, view);
+}
+
 /*
  * Tag
  */
@@ -2640,8 +2694,9 @@ redisplay_region (GtkTextBTree      *tree,
         start_y -= ld->top_ink;
 
       ld = _gtk_text_line_get_data (end_line, view->view_id);
+      end_y += line_data_get_height (ld, view);
       if (ld)
-        end_y += ld->height + ld->bottom_ink;
+        end_y += ld->bottom_ink;
 
       if (cursors_only)
 	gtk_text_layout_cursors_changed (view->layout, start_y,
@@ -5105,8 +5160,7 @@ gtk_text_btree_node_validate (BTreeView         *view,
             break;
           else
             {
-              if (ld)
-                state->old_height += ld->height;
+              state->old_height += line_data_get_height (ld, view);
               ld = gtk_text_layout_wrap (view->layout, line, ld);
               state->new_height += ld->height;
 
@@ -5134,10 +5188,8 @@ gtk_text_btree_node_validate (BTreeView         *view,
             node_valid = FALSE;
 
           if (ld)
-            {
-              node_width = MAX (ld->width, node_width);
-              node_height += ld->height;
-            }
+            node_width = MAX (ld->width, node_width);
+          node_height += line_data_get_height (ld, view);
 
           line = line->next;
         }
@@ -5281,7 +5333,7 @@ _gtk_text_btree_validate (GtkTextBTree *tree,
 
 static void
 gtk_text_btree_node_compute_view_aggregates (GtkTextBTreeNode *node,
-                                             gpointer          view_id,
+                                             BTreeView        *view,
                                              int              *width_out,
                                              int              *height_out,
                                              gboolean         *valid_out)
@@ -5296,16 +5348,14 @@ gtk_text_btree_node_compute_view_aggregates (GtkTextBTreeNode *node,
 
       while (line != NULL)
         {
-          GtkTextLineData *ld = _gtk_text_line_get_data (line, view_id);
+          GtkTextLineData *ld = _gtk_text_line_get_data (line, view->view_id);
 
           if (!ld || !ld->valid)
             valid = FALSE;
 
           if (ld)
-            {
-              width = MAX (ld->width, width);
-              height += ld->height;
-            }
+            width = MAX (ld->width, width);
+          height += line_data_get_height (ld, view);
 
           line = line->next;
         }
@@ -5316,7 +5366,7 @@ gtk_text_btree_node_compute_view_aggregates (GtkTextBTreeNode *node,
 
       while (child)
         {
-          NodeData *child_nd = node_data_find (child->node_data, view_id);
+          NodeData *child_nd = node_data_find (child->node_data, view->view_id);
 
           if (!child_nd || !child_nd->valid)
             valid = FALSE;
@@ -5326,6 +5376,10 @@ gtk_text_btree_node_compute_view_aggregates (GtkTextBTreeNode *node,
               width = MAX (child_nd->width, width);
               height += child_nd->height;
             }
+          else
+            {
+              height += child->num_lines * view->estimated_line_height;
+            }
 
           child = child->next;
         }
@@ -5342,14 +5396,14 @@ gtk_text_btree_node_compute_view_aggregates (GtkTextBTreeNode *node,
  */
 static NodeData *
 gtk_text_btree_node_check_valid (GtkTextBTreeNode *node,
-                                 gpointer          view_id)
+                                 BTreeView        *view)
 {
-  NodeData *nd = gtk_text_btree_node_ensure_data (node, view_id);
+  NodeData *nd = gtk_text_btree_node_ensure_data (node, view->view_id);
   gboolean valid;
   int width;
   int height;
 
-  gtk_text_btree_node_compute_view_aggregates (node, view_id,
+  gtk_text_btree_node_compute_view_aggregates (node, view,
                                                &width, &height, &valid);
   nd->width = width;
   nd->height = height;
@@ -5360,28 +5414,28 @@ gtk_text_btree_node_check_valid (GtkTextBTreeNode *node,
 
 static void
 gtk_text_btree_node_check_valid_upward (GtkTextBTreeNode *node,
-                                        gpointer          view_id)
+                                        BTreeView        *view)
 {
   while (node)
     {
-      gtk_text_btree_node_check_valid (node, view_id);
+      gtk_text_btree_node_check_valid (node, view);
       node = node->parent;
     }
 }
 
 static NodeData *
 gtk_text_btree_node_check_valid_downward (GtkTextBTreeNode *node,
-                                          gpointer          view_id)
+                                          BTreeView        *view)
 {
   if (node->level == 0)
     {
-      return gtk_text_btree_node_check_valid (node, view_id);
+      return gtk_text_btree_node_check_valid (node, view);
     }
   else
     {
       GtkTextBTreeNode *child = node->children.node;
 
-      NodeData *nd = gtk_text_btree_node_ensure_data (node, view_id);
+      NodeData *nd = gtk_text_btree_node_ensure_data (node, view->view_id);
 
       nd->valid = TRUE;
       nd->width = 0;
@@ -5389,7 +5443,7 @@ gtk_text_btree_node_check_valid_downward (GtkTextBTreeNode *node,
 
       while (child)
         {
-          NodeData *child_nd = gtk_text_btree_node_check_valid_downward (child, view_id);
+          NodeData *child_nd = gtk_text_btree_node_check_valid_downward (child, view);
 
           if (!child_nd->valid)
             nd->valid = FALSE;
@@ -5431,7 +5485,7 @@ _gtk_text_btree_validate_line (GtkTextBTree     *tree,
   if (!ld || !ld->valid)
     {
       gtk_text_layout_wrap (view->layout, line, ld);
-      gtk_text_btree_node_check_valid_upward (line->parent, view_id);
+      gtk_text_btree_node_check_valid_upward (line->parent, view);
     }
 }
 
@@ -5956,6 +6010,22 @@ post_insert_fixup (GtkTextBTree *tree,
     {
       node->num_lines += line_count_delta;
       node->num_chars += char_count_delta;
+
+      /* The new lines have no line data yet, account for them
+       * with the estimated line height of each view.
+       */
+      if (line_count_delta != 0)
+        {
+          BTreeView *view;
+
+          for (view = tree->views; view != NULL; view = view->next)
+            {
+              NodeData *nd = node_data_find (node->node_data, view->view_id);
+
+              if (nd)
+                nd->height += line_count_delta * view->estimated_line_height;
+            }
+        }
     }
   node = line->parent;
   node->num_children += line_count_delta;
@@ -6190,7 +6260,7 @@ recompute_node_counts (GtkTextBTree *tree, GtkTextBTreeNode *node)
   view = tree->views;
   while (view)
     {
-      gtk_text_btree_node_check_valid (node, view->view_id);
+      gtk_text_btree_node_check_valid (node, view);
       view = view->next;
     }
 
@@ -6614,7 +6684,7 @@ gtk_text_btree_node_view_check_consistency (GtkTextBTree     *tree,
     g_error ("Node has data for a view %p no longer attached to the tree",
              nd->view_id);
 
-  gtk_text_btree_node_compute_view_aggregates (node, nd->view_id,
+  gtk_text_btree_node_compute_view_aggregates (node, view,
                                                &width, &height, &valid);
 
   /* valid aggregate not checked the same as width/height, because on
@@ -7037,6 +7107,96 @@ _gtk_text_btree_check (GtkTextBTree *tree)
     }
 }
 
+static void
+gtk_text_btree_node_get_memory_usage (GtkTextBTreeNode        *node,
+                                      GtkTextBTreeMemoryUsage *usage)
+{
+  NodeData *nd;
+  Summary *summary;
+
+  usage->n_nodes++;
+  usage->total_bytes += sizeof (GtkTextBTreeNode);
+
+  for (nd = node->node_data; nd != NULL; nd = nd->next)
+    {
+      usage->n_node_data++;
+      usage->total_bytes += sizeof (NodeData);
+    }
+
+  for (summary = node->summary; summary != NULL; summary = summary->next)
+    {
+      usage->n_summaries++;
+      usage->total_bytes += sizeof (Summary);
+    }
+
+  if (node->level == 0)
+    {
+      GtkTextLine *line;
+
+      for (line = node->children.line; line != NULL; line = line->next)
+        {
+          GtkTextLineSegment *seg;
+          GtkTextLineData *ld;
+
+          usage->n_lines++;
+          usage->total_bytes += sizeof (GtkTextLine);
+
+          for (ld = line->views; ld != NULL; ld = ld->next)
+            {
+              usage->n_line_data++;
+              usage->total_bytes += sizeof (GtkTextLineData);
+            }
+
+          for (seg = line->segments; seg != NULL; seg = seg->next)
+            {
+              if (seg->type == &gtk_text_char_type)
+                {
+                  usage->n_char_segments++;
+                  usage->text_bytes += seg->byte_count;
+                }
+              else
+                {
+                  usage->n_other_segments++;
+                }
+              usage->total_bytes += gtk_text_line_segment_get_size (seg);
+            }
+        }
+    }
+  else
+    {
+      GtkTextBTreeNode *child;
+
+      for (child = node->children.node; child != NULL; child = child->next)
+        gtk_text_btree_node_get_memory_usage (child, usage);
+    }
+}
+
+/**
+ * _gtk_text_btree_get_memory_usage:
+ * @tree: a GtkTextBTree
+ * @usage: (out): return location for the memory usage
+ *
+ * Counts the nodes, lines and segments of the tree, the per-view
+ * and per-tag data attached to them, and the memory all of this
+ * takes up, not counting allocator overhead. Tags, marks and
+ * child anchors themselves are not included.
+ * This walks the whole tree, so it is meant for debugging.
+ */
+void
+_gtk_text_btree_get_memory_usage (GtkTextBTree            *tree,
+                                  GtkTextBTreeMemoryUsage *usage)
+{
+  g_return_if_fail (tree != NULL);
+  g_return_if_fail (usage != NULL);
+
+  memset (usage, 0, sizeof (GtkTextBTreeMemoryUsage));
+
+  usage->total_bytes += sizeof (GtkTextBTree);
+  usage->total_bytes += g_slist_length (tree->tag_infos) * (sizeof (GSList) + sizeof (GtkTextTagInfo));
+
+  gtk_text_btree_node_get_memory_usage (tree->root_node, usage);
+}
+
 void _gtk_text_btree_spew_line (GtkTextBTree* tree, GtkTextLine* line);
 void _gtk_text_btree_spew_segment (GtkTextBTree* tree, GtkTextLineSegment* seg);
 void _gtk_text_btree_spew_node (GtkTextBTreeNode *node, int indent);
@@ -7047,10 +7207,20 @@ _gtk_text_btree_spew (GtkTextBTree *tree)
 {
   GtkTextLine * line;
   int real_line;
+  GtkTextBTreeMemoryUsage usage;
 
   printf ("%d lines in tree %p\n",
           _gtk_text_btree_line_count (tree), tree);
 
+  _gtk_text_btree_get_memory_usage (tree, &usage);
+  printf ("%u nodes, %u node data, %u tag summaries, %u lines, %u line data, "
+          "%u char segments, %u other segments\n"
+          "%" G_GSIZE_FORMAT " bytes of text in %" G_GSIZE_FORMAT " bytes\n",
+          usage.n_nodes, usage.n_node_data, usage.n_summaries,
+          usage.n_lines, usage.n_line_data,
+          usage.n_char_segments, usage.n_other_segments,
+          usage.text_bytes, usage.total_bytes);
+
   line = _gtk_text_btree_get_line (tree, 0, &real_line);
 
   while (line != NULL)
@@ -95,6 +95,9 @@ void         _gtk_text_btree_get_view_size     (GtkTextBTree      *tree,
                                                 gpointer           view_id,
                                                 int               *width,
                                                 int               *height);
+void         _gtk_text_btree_set_estimated_line_height (GtkTextBTree *tree,
+                                                        gpointer      view_id,
+                                                        int           height);
 gboolean     _gtk_text_btree_is_valid          (GtkTextBTree      *tree,
                                                 gpointer           view_id);
 gboolean     _gtk_text_btree_validate          (GtkTextBTree      *tree,
@@ -322,6 +325,22 @@ GtkTextLine    *    _gtk_text_line_previous_could_contain_tag (GtkTextLine
 GtkTextLineData    *_gtk_text_line_data_new                   (GtkTextLayout     *layout,
                                                                GtkTextLine       *line);
 
+/* Memory usage of the text and the structures holding it */
+typedef struct {
+  guint n_nodes;
+  guint n_node_data;
+  guint n_summaries;
+  guint n_lines;
+  guint n_line_data;
+  guint n_char_segments;
+  guint n_other_segments;
+  gsize text_bytes;
+  gsize total_bytes;
+} GtkTextBTreeMemoryUsage;
+
+void _gtk_text_btree_get_memory_usage (GtkTextBTree            *tree,
+                                       GtkTextBTreeMemoryUsage *usage);
+
 /* Debug */
 void _gtk_text_btree_check (GtkTextBTree *tree);
 void _gtk_text_btree_spew (GtkTextBTree *tree);
@@ -1178,6 +1178,18 @@ gtk_text_buffer_set_text (GtkTextBuffer *buffer,
     }
 
   gtk_text_history_end_irreversible_action (buffer->priv->history);
+
+  if (GTK_DEBUG_CHECK (TEXT))
+    {
+      GtkTextBTreeMemoryUsage usage;
+
+      _gtk_text_btree_get_memory_usage (get_btree (buffer), &usage);
+      gdk_debug_message ("GtkTextBuffer %p: %u lines, %" G_GSIZE_FORMAT " bytes of text "
+                         "in %" G_GSIZE_FORMAT " bytes (%u nodes, %u line data, %u segments)",
+                         buffer, usage.n_lines, usage.text_bytes, usage.total_bytes,
+                         usage.n_nodes, usage.n_line_data,
+                         usage.n_char_segments + usage.n_other_segments);
+    }
 }
 
 /*
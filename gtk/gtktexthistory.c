@@ -36,8 +36,14 @@
  * gtk_text_history_end_irreversible_action() can be used to denote a
  * section of operations that cannot be undone. This will cause all previous
  * changes tracked by the GtkTextHistory to be discarded.
+ *
+ * Besides the number of undo levels, the history is bounded by the memory
+ * used for the actions and their text. When that goes over max_bytes, the
+ * oldest actions are discarded, but the most recent one is always kept.
  */
 
+#define DEFAULT_MAX_BYTES (64 * 1024 * 1024)
+
 typedef struct _Action     Action;
 typedef enum   _ActionKind ActionKind;
 
@@ -56,6 +62,7 @@ struct _Action
 {
   ActionKind kind;
   GList link;
+  gsize size;
   guint is_modified : 1;
   guint is_modified_set : 1;
   union {
@@ -98,6 +105,8 @@ struct _GtkTextHistory
   guint               irreversible;
   guint               in_user;
   guint               max_undo_levels;
+  gsize               max_bytes;
+  gsize               n_bytes;
 
   guint               can_undo : 1;
   guint               can_redo : 1;
@@ -288,10 +297,32 @@ action_new (ActionKind kind)
   action = g_new0 (Action, 1);
   action->kind = kind;
   action->link.data = action;
+  action->size = sizeof (Action);
 
   return action;
 }
 
+static inline gsize
+istring_get_heap_size (const IString *str)
+{
+  return istring_is_inline (str) ? 0 : str->n_bytes + 1;
+}
+
+/* Groups keep their size up to date as children are added,
+ * this is for the actions that carry text.
+ */
+static void
+action_update_size (Action *action)
+{
+  if (action->kind == ACTION_KIND_INSERT)
+    action->size = sizeof (Action) + istring_get_heap_size (&action->u.insert.istr);
+  else if (action->kind == ACTION_KIND_DELETE_BACKSPACE ||
+           action->kind == ACTION_KIND_DELETE_KEY ||
+           action->kind == ACTION_KIND_DELETE_PROGRAMMATIC ||
+           action->kind == ACTION_KIND_DELETE_SELECTION)
+    action->size = sizeof (Action) + istring_get_heap_size (&action->u.delete.istr);
+}
+
 static void
 action_free (Action *action)
 {
@@ -369,11 +400,17 @@ action_chain (Action   *action,
        */
       if (tail != NULL && tail->kind == other->kind)
         {
+          gsize tail_size = tail->size;
+
           if (action_chain (tail, other, in_user_action))
-            return TRUE;
+            {
+              action->size += tail->size - tail_size;
+              return TRUE;
+            }
         }
 
       g_queue_push_tail_link (&action->u.group.actions, &other->link);
+      action->size += other->size;
 
       return TRUE;
     }
@@ -427,18 +464,41 @@ action_chain (Action   *action,
 
       istring_append (&action->u.insert.istr, &other->u.insert.istr);
       action->u.insert.end += other->u.insert.end - other->u.insert.begin;
+      action_update_size (action);
       action_free (other);
 
       return TRUE;
     }
 
     case ACTION_KIND_DELETE_PROGRAMMATIC:
-      /* We can't tell if this should be chained because we don't
-       * have a group to coalesce. But unless each action deletes
-       * a single character, the overhead isn't too bad as we embed
-       * the strings in the action.
+      /* Outside of a user action we can't tell if this should be
+       * chained because we don't have a group to coalesce. But unless
+       * each action deletes a single character, the overhead isn't
+       * too bad as we embed the strings in the action.
+       *
+       * Within a group, the deletes are undone together anyway, so
+       * join adjacent ones like the key and backspace deletes below.
        */
-      return FALSE;
+      if (!in_user_action)
+        return FALSE;
+
+      if (other->u.delete.begin == action->u.delete.begin)
+        {
+          istring_append (&action->u.delete.istr, &other->u.delete.istr);
+          action->u.delete.end += other->u.delete.end - other->u.delete.begin;
+        }
+      else if (other->u.delete.end == action->u.delete.begin)
+        {
+          istring_prepend (&action->u.delete.istr, &other->u.delete.istr);
+          action->u.delete.begin = other->u.delete.begin;
+        }
+      else
+        return FALSE;
+
+      action_update_size (action);
+      action_free (other);
+
+      return TRUE;
 
     case ACTION_KIND_DELETE_SELECTION:
       /* Don't join selection deletes as they should appear as a single
@@ -452,6 +512,7 @@ action_chain (Action   *action,
           istring_prepend (&action->u.delete.istr,
                            &other->u.delete.istr);
           action->u.delete.begin = other->u.delete.begin;
+          action_update_size (action);
           action_free (other);
           return TRUE;
         }
@@ -466,6 +527,7 @@ action_chain (Action   *action,
             {
               istring_append (&action->u.delete.istr, &other->u.delete.istr);
               action->u.delete.end += other->u.delete.istr.n_chars;
+              action_update_size (action);
               action_free (other);
               return TRUE;
             }
@@ -534,6 +596,20 @@ gtk_text_history_do_select (GtkTextHistory *self,
   self->funcs.select (self->funcs_data, selection_insert, selection_bound);
 }
 
+static void
+gtk_text_history_clear_queue (GtkTextHistory *self,
+                              GQueue         *queue)
+{
+  for (const GList *iter = queue->head; iter; iter = iter->next)
+    {
+      const Action *action = iter->data;
+
+      self->n_bytes -= action->size;
+    }
+
+  clear_action_queue (queue);
+}
+
 static void
 gtk_text_history_truncate_one (GtkTextHistory *self)
 {
@@ -541,12 +617,14 @@ gtk_text_history_truncate_one (GtkTextHistory *self)
     {
       Action *action = g_queue_peek_head (&self->undo_queue);
       g_queue_unlink (&self->undo_queue, &action->link);
+      self->n_bytes -= action->size;
       action_free (action);
     }
   else if (self->redo_queue.length > 0)
     {
       Action *action = g_queue_peek_tail (&self->redo_queue);
       g_queue_unlink (&self->redo_queue, &action->link);
+      self->n_bytes -= action->size;
       action_free (action);
     }
   else
@@ -560,11 +638,18 @@ gtk_text_history_truncate (GtkTextHistory *self)
 {
   g_assert (GTK_IS_TEXT_HISTORY (self));
 
-  if (self->max_undo_levels == 0)
-    return;
+  if (self->max_undo_levels > 0)
+    {
+      while (self->undo_queue.length + self->redo_queue.length > self->max_undo_levels)
+        gtk_text_history_truncate_one (self);
+    }
 
-  while (self->undo_queue.length + self->redo_queue.length > self->max_undo_levels)
-    gtk_text_history_truncate_one (self);
+  if (self->max_bytes > 0)
+    {
+      while (self->n_bytes > self->max_bytes &&
+             self->undo_queue.length + self->redo_queue.length > 1)
+        gtk_text_history_truncate_one (self);
+    }
 }
 
 static void
@@ -590,6 +675,7 @@ static void
 gtk_text_history_init (GtkTextHistory *self)
 {
   self->enabled = TRUE;
+  self->max_bytes = DEFAULT_MAX_BYTES;
   self->selection.insert = -1;
   self->selection.bound = -1;
 }
@@ -644,24 +730,29 @@ gtk_text_history_push (GtkTextHistory *self,
                        Action         *action)
 {
   Action *peek;
+  gsize peek_size;
   gboolean in_user_action;
 
   g_assert (GTK_IS_TEXT_HISTORY (self));
   g_assert (self->enabled);
   g_assert (action != NULL);
 
-  while (self->redo_queue.length > 0)
-    {
-      peek = g_queue_peek_head (&self->redo_queue);
-      g_queue_unlink (&self->redo_queue, &peek->link);
-      action_free (peek);
-    }
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   peek = g_queue_peek_tail (&self->undo_queue);
   in_user_action = self->in_user > 0;
 
+  peek_size = peek != NULL ? peek->size : 0;
+
   if (peek == NULL || !action_chain (peek, action, in_user_action))
-    g_queue_push_tail_link (&self->undo_queue, &action->link);
+    {
+      g_queue_push_tail_link (&self->undo_queue, &action->link);
+      self->n_bytes += action->size;
+    }
+  else
+    {
+      self->n_bytes += peek->size - peek_size;
+    }
 
   gtk_text_history_truncate (self);
   gtk_text_history_update_state (self);
@@ -951,7 +1042,7 @@ gtk_text_history_end_user_action (GtkTextHistory *self)
   return_if_applying (self);
   return_if_irreversible (self);
 
-  clear_action_queue (&self->redo_queue);
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   peek = g_queue_peek_tail (&self->undo_queue);
 
@@ -974,6 +1065,7 @@ gtk_text_history_end_user_action (GtkTextHistory *self)
   if (action_group_is_empty (peek))
     {
       g_queue_unlink (&self->undo_queue, &peek->link);
+      self->n_bytes -= peek->size;
       action_free (peek);
       goto update_state;
     }
@@ -991,6 +1083,7 @@ gtk_text_history_end_user_action (GtkTextHistory *self)
 
       g_queue_unlink (&peek->u.group.actions, link_);
       g_queue_unlink (&self->undo_queue, &peek->link);
+      self->n_bytes -= peek->size;
       action_free (peek);
 
       gtk_text_history_push (self, replaced);
@@ -1023,8 +1116,8 @@ gtk_text_history_begin_irreversible_action (GtkTextHistory *self)
 
   self->irreversible++;
 
-  clear_action_queue (&self->undo_queue);
-  clear_action_queue (&self->redo_queue);
+  gtk_text_history_clear_queue (self, &self->undo_queue);
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   gtk_text_history_update_state (self);
 }
@@ -1045,8 +1138,8 @@ gtk_text_history_end_irreversible_action (GtkTextHistory *self)
 
   self->irreversible--;
 
-  clear_action_queue (&self->undo_queue);
-  clear_action_queue (&self->redo_queue);
+  gtk_text_history_clear_queue (self, &self->undo_queue);
+  gtk_text_history_clear_queue (self, &self->redo_queue);
 
   gtk_text_history_update_state (self);
 }
@@ -1157,6 +1250,7 @@ gtk_text_history_text_inserted (GtkTextHistory *self,
   action->u.insert.begin = position;
   action->u.insert.end = position + n_chars;
   istring_set (&action->u.insert.istr, text, len, n_chars);
+  action_update_size (action);
 
   gtk_text_history_push (self, action);
 }
@@ -1195,6 +1289,7 @@ gtk_text_history_text_deleted (GtkTextHistory *self,
   action->u.delete.selection.insert = self->selection.insert;
   action->u.delete.selection.bound = self->selection.bound;
   istring_set (&action->u.delete.istr, text, len, ABS (end - begin));
+  action_update_size (action);
 
   gtk_text_history_push (self, action);
 }
@@ -1223,8 +1318,8 @@ gtk_text_history_set_enabled (GtkTextHistory *self,
         {
           self->irreversible = 0;
           self->in_user = 0;
-          clear_action_queue (&self->undo_queue);
-          clear_action_queue (&self->redo_queue);
+          gtk_text_history_clear_queue (self, &self->undo_queue);
+          gtk_text_history_clear_queue (self, &self->redo_queue);
         }
 
       gtk_text_history_update_state (self);
@@ -1251,3 +1346,33 @@ gtk_text_history_set_max_undo_levels (GtkTextHistory *self,
       gtk_text_history_truncate (self);
     }
 }
+
+gsize
+gtk_text_history_get_max_bytes (GtkTextHistory *self)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_HISTORY (self), 0);
+
+  return self->max_bytes;
+}
+
+/*
+ * gtk_text_history_set_max_bytes:
+ * @self: a GtkTextHistory
+ * @max_bytes: the memory budget, or 0 for no limit
+ *
+ * Sets how much memory the actions may use before the oldest ones
+ * are discarded. The most recent action is kept regardless.
+ */
+void
+gtk_text_history_set_max_bytes (GtkTextHistory *self,
+                                gsize           max_bytes)
+{
+  g_return_if_fail (GTK_IS_TEXT_HISTORY (self));
+
+  if (self->max_bytes != max_bytes)
+    {
+      self->max_bytes = max_bytes;
+      gtk_text_history_truncate (self);
+      gtk_text_history_update_state (self);
+    }
+}
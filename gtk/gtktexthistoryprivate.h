@@ -74,6 +74,9 @@ void            gtk_text_history_text_deleted              (GtkTextHistory
                                                             guint                      end,
                                                             const char                *text,
                                                             int                        len);
+gsize           gtk_text_history_get_max_bytes             (GtkTextHistory            *self);
+void            gtk_text_history_set_max_bytes             (GtkTextHistory            *self,
+                                                            gsize                      max_bytes);
 gboolean        gtk_text_history_get_enabled               (GtkTextHistory            *self);
 void            gtk_text_history_set_enabled               (GtkTextHistory            *self,
                                                             gboolean                   enabled);
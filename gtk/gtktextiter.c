@@ -5063,6 +5063,245 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
   return retval;
 }
 
+/* Appends the character offsets of all non-overlapping occurrences
+ * of @needle in @line_text to @offsets. If @case_insensitive is set,
+ * @needle must already be casefolded and normalized.
+ */
+static void
+line_find_all (const char *line_text,
+               const char *needle,
+               gboolean    case_insensitive,
+               GArray     *offsets)
+{
+  gsize needle_len = strlen (needle);
+
+  if (!case_insensitive)
+    {
+      const char *p, *found;
+      int offset = 0;
+
+      p = line_text;
+      while ((found = strstr (p, needle)) != NULL)
+        {
+          offset += g_utf8_strlen (p, found - p);
+          g_array_append_val (offsets, offset);
+
+          offset += g_utf8_strlen (found, needle_len);
+          p = found + needle_len;
+        }
+    }
+  else
+    {
+      char *casefold;
+      char *caseless;
+      const char *p, *h;
+      int needle_chars;
+      int i, consumed, offset;
+
+      casefold = g_utf8_casefold (line_text, -1);
+      caseless = g_utf8_normalize (casefold, -1, G_NORMALIZE_NFD);
+      g_free (casefold);
+
+      needle_chars = g_utf8_strlen (needle, needle_len);
+
+      /* i counts characters in the caseless text, offset the characters
+       * of @line_text whose decompositions make up the first consumed
+       * characters of it. This is pointer_from_offset_skipping_decomp(),
+       * done incrementally instead of from the start for every match.
+       */
+      h = line_text;
+      consumed = 0;
+      offset = 0;
+      i = 0;
+      p = caseless;
+
+      while (*p)
+        {
+          if (!exact_prefix_cmp (p, needle, needle_len))
+            {
+              p = g_utf8_next_char (p);
+              i++;
+              continue;
+            }
+
+          while (consumed < i && *h)
+            {
+              const char *q = g_utf8_next_char (h);
+              char *normal;
+
+              casefold = g_utf8_casefold (h, q - h);
+              normal = g_utf8_normalize (casefold, -1, G_NORMALIZE_NFD);
+              consumed += g_utf8_strlen (normal, -1);
+              g_free (casefold);
+              g_free (normal);
+
+              h = q;
+              offset++;
+            }
+
+          g_array_append_val (offsets, offset);
+
+          p += needle_len;
+          i += needle_chars;
+        }
+
+      g_free (caseless);
+    }
+}
+
+/**
+ * gtk_text_iter_forward_search_all:
+ * @iter: start of search
+ * @str: a search string
+ * @flags: flags affecting how the search is done
+ * @limit: (nullable): location of last possible match end, or %NULL for the end of the buffer
+ * @n_iters: (out): return location for the number of returned iters
+ *
+ * Searches forward for all occurrences of @str.
+ *
+ * This finds the same matches as calling [method@Gtk.TextIter.forward_search]
+ * repeatedly, starting each search at the end of the previous match, but
+ * only extracts (and casefolds) the text of every line once, which makes
+ * it a lot faster for highlighting all matches in large buffers.
+ *
+ * The matches are returned as pairs of iters, each match start
+ * followed by its end, so @n_iters is twice the number of matches.
+ * Unlike [method@Gtk.TextIter.forward_search], an empty @str
+ * does not match anything.
+ *
+ * Returns: (array length=n_iters) (transfer full) (nullable): the
+ *   start and end iters of all matches, or %NULL if there are none
+ *
+ * Since: 4.16
+ */
+GtkTextIter *
+gtk_text_iter_forward_search_all (const GtkTextIter *iter,
+                                  const char        *str,
+                                  GtkTextSearchFlags flags,
+                                  const GtkTextIter *limit,
+                                  gsize             *n_iters)
+{
+  char **lines;
+  GArray *matches;
+  GArray *offsets;
+  GtkTextIter search;
+  GtkTextIter match, end;
+  gboolean visible_only;
+  gboolean slice;
+  gboolean case_insensitive;
+
+  g_return_val_if_fail (iter != NULL, NULL);
+  g_return_val_if_fail (str != NULL, NULL);
+  g_return_val_if_fail (n_iters != NULL, NULL);
+
+  *n_iters = 0;
+
+  if (*str == '\0')
+    return NULL;
+
+  if (limit &&
+      gtk_text_iter_compare (iter, limit) >= 0)
+    return NULL;
+
+  visible_only = (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) != 0;
+  slice = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) == 0;
+  case_insensitive = (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE) != 0;
+
+  matches = g_array_new (FALSE, FALSE, sizeof (GtkTextIter));
+  search = *iter;
+
+  lines = strbreakup (str, "\n", -1, NULL, case_insensitive);
+
+  if (lines[0] != NULL && lines[1] != NULL)
+    {
+      /* The search string spans lines, so matches can't be found
+       * line by line. Fall back to repeated searches.
+       */
+      while (gtk_text_iter_forward_search (&search, str, flags, &match, &end, limit))
+        {
+          g_array_append_val (matches, match);
+          g_array_append_val (matches, end);
+          search = end;
+        }
+
+      g_strfreev (lines);
+
+      *n_iters = matches->len;
+      return (GtkTextIter *) g_array_free (matches, matches->len == 0);
+    }
+
+  offsets = g_array_new (FALSE, FALSE, sizeof (int));
+
+  do
+    {
+      GtkTextIter next, cursor;
+      char *line_text;
+      int cursor_offset;
+      guint i;
+
+      if (limit &&
+          gtk_text_iter_compare (&search, limit) >= 0)
+        break;
+
+      next = search;
+      if (!gtk_text_iter_forward_line (&next) && gtk_text_iter_equal (&search, &next))
+        break;
+
+      if (slice)
+        {
+          if (visible_only)
+            line_text = gtk_text_iter_get_visible_slice (&search, &next);
+          else
+            line_text = gtk_text_iter_get_slice (&search, &next);
+        }
+      else
+        {
+          if (visible_only)
+            line_text = gtk_text_iter_get_visible_text (&search, &next);
+          else
+            line_text = gtk_text_iter_get_text (&search, &next);
+        }
+
+      g_array_set_size (offsets, 0);
+      line_find_all (line_text, lines[0], case_insensitive, offsets);
+      g_free (line_text);
+
+      cursor = search;
+      cursor_offset = 0;
+
+      for (i = 0; i < offsets->len; i++)
+        {
+          int offset = g_array_index (offsets, int, i);
+
+          forward_chars_with_skipping (&cursor, offset - cursor_offset,
+                                       visible_only, !slice, FALSE);
+          cursor_offset = offset;
+
+          match = cursor;
+          end = cursor;
+          forward_chars_with_skipping (&end, g_utf8_strlen (lines[0], -1),
+                                       visible_only, !slice, case_insensitive);
+
+          if (limit &&
+              gtk_text_iter_compare (&end, limit) > 0)
+            goto out;
+
+          g_array_append_val (matches, match);
+          g_array_append_val (matches, end);
+        }
+
+      search = next;
+    }
+  while (!gtk_text_iter_is_end (&search));
+
+out:
+  g_array_free (offsets, TRUE);
+  g_strfreev (lines);
+
+  *n_iters = matches->len;
+  return (GtkTextIter *) g_array_free (matches, matches->len == 0);
+}
+
 static gboolean
 vectors_equal_ignoring_trailing (char     **vec1,
                                  char     **vec2,
@@ -386,6 +386,13 @@ gboolean gtk_text_iter_forward_search  (const GtkTextIter *iter,
                                         GtkTextIter       *match_end,
                                         const GtkTextIter *limit);
 
+GDK_AVAILABLE_IN_4_16
+GtkTextIter *gtk_text_iter_forward_search_all (const GtkTextIter *iter,
+                                               const char        *str,
+                                               GtkTextSearchFlags flags,
+                                               const GtkTextIter *limit,
+                                               gsize             *n_iters);
+
 GDK_AVAILABLE_IN_ALL
 gboolean gtk_text_iter_backward_search (const GtkTextIter *iter,
                                         const char        *str,
@@ -353,6 +353,9 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
       g_object_ref (buffer);
 
       _gtk_text_btree_add_view (_gtk_text_buffer_get_btree (buffer), layout);
+      _gtk_text_btree_set_estimated_line_height (_gtk_text_buffer_get_btree (buffer),
+                                                 layout,
+                                                 layout->estimated_line_height);
 
       /* Bind to all signals that move the insert mark. */
       g_signal_connect_after (layout->buffer, "mark-set",
@@ -373,11 +376,52 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
     }
 }
 
+/* Lines are only laid out as they are needed, the other ones
+ * are assumed to be one line of the default font high. This
+ * keeps the total height of large buffers close to the real
+ * one without having to validate all of them up front.
+ */
+static void
+gtk_text_layout_update_estimated_line_height (GtkTextLayout *layout)
+{
+  int height = 0;
+
+  if (layout->ltr_context != NULL && layout->default_style != NULL)
+    {
+      PangoFontMetrics *metrics;
+
+      metrics = pango_context_get_metrics (layout->ltr_context,
+                                           layout->default_style->font,
+                                           NULL);
+      height = pango_font_metrics_get_height (metrics);
+      if (height == 0)
+        height = pango_font_metrics_get_ascent (metrics) +
+                 pango_font_metrics_get_descent (metrics);
+      pango_font_metrics_unref (metrics);
+
+      height = PANGO_PIXELS_CEIL (height) +
+               layout->default_style->pixels_above_lines +
+               layout->default_style->pixels_below_lines;
+    }
+
+  if (height == layout->estimated_line_height)
+    return;
+
+  layout->estimated_line_height = height;
+
+  if (layout->buffer != NULL)
+    _gtk_text_btree_set_estimated_line_height (_gtk_text_buffer_get_btree (layout->buffer),
+                                               layout,
+                                               height);
+}
+
 void
 gtk_text_layout_default_style_changed (GtkTextLayout *layout)
 {
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
 
+  gtk_text_layout_update_estimated_line_height (layout);
+
   DV (g_print ("invalidating all due to default style change (%s)\n", G_STRLOC));
   gtk_text_layout_invalidate_all (layout);
 }
@@ -427,6 +471,8 @@ gtk_text_layout_set_contexts (GtkTextLayout *layout,
       g_object_ref (layout->rtl_context);
     }
 
+  gtk_text_layout_update_estimated_line_height (layout);
+
   DV (g_print ("invalidating all due to new pango contexts (%s)\n", G_STRLOC));
   gtk_text_layout_invalidate_all (layout);
 }
@@ -933,7 +979,7 @@ gtk_text_layout_validate_yrange (GtkTextLayout *layout,
           int old_height, new_height;
           int top_ink, bottom_ink;
 
-	  old_height = line_data ? line_data->height : 0;
+	  old_height = line_data ? line_data->height : layout->estimated_line_height;
           top_ink = line_data ? line_data->top_ink : 0;
           bottom_ink = line_data ? line_data->bottom_ink : 0;
 
@@ -974,7 +1020,7 @@ gtk_text_layout_validate_yrange (GtkTextLayout *layout,
           int old_height, new_height;
           int top_ink, bottom_ink;
 
-	  old_height = line_data ? line_data->height : 0;
+	  old_height = line_data ? line_data->height : layout->estimated_line_height;
           top_ink = line_data ? line_data->top_ink : 0;
           bottom_ink = line_data ? line_data->bottom_ink : 0;
 
@@ -1029,7 +1075,9 @@ gtk_text_layout_validate_yrange (GtkTextLayout *layout,
  *   than one paragraph beyond this limit will be validated)
  *
  * Validate regions of a `GtkTextLayout`. The ::changed signal will
- * be emitted for each region validated.
+ * be emitted for the validated regions. Neighboring regions are
+ * reported together, so that views don't have to update their
+ * scroll position for every paragraph.
  **/
 void
 gtk_text_layout_validate (GtkTextLayout *layout,
@@ -1037,6 +1085,8 @@ gtk_text_layout_validate (GtkTextLayout *layout,
 {
   GtkTextBTree *btree;
   int y, old_height, new_height;
+  int changed_y = 0, changed_old_height = 0, changed_new_height = 0;
+  gboolean has_changes = FALSE;
 
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
 
@@ -1048,8 +1098,41 @@ gtk_text_layout_validate (GtkTextLayout *layout,
     {
       max_pixels -= new_height;
 
+      if (!has_changes)
+        {
+          changed_y = y;
+          changed_old_height = old_height;
+          changed_new_height = new_height;
+          has_changes = TRUE;
+        }
+      else if (y >= changed_y + changed_new_height)
+        {
+          /* Below the changed region, take the lines in between along */
+          changed_old_height += y - (changed_y + changed_new_height) + old_height;
+          changed_new_height = y + new_height - changed_y;
+        }
+      else if (y + old_height <= changed_y)
+        {
+          /* Above the changed region, which moved by the height difference */
+          changed_old_height += changed_y - y;
+          changed_new_height += changed_y - (y + old_height) + new_height;
+          changed_y = y;
+        }
+      else
+        {
+          update_layout_size (layout);
+          gtk_text_layout_emit_changed (layout, changed_y, changed_old_height, changed_new_height);
+
+          changed_y = y;
+          changed_old_height = old_height;
+          changed_new_height = new_height;
+        }
+    }
+
+  if (has_changes)
+    {
       update_layout_size (layout);
-      gtk_text_layout_emit_changed (layout, y, old_height, new_height);
+      gtk_text_layout_emit_changed (layout, changed_y, changed_old_height, changed_new_height);
     }
 }
 
@@ -3015,7 +3098,7 @@ gtk_text_layout_get_line_yrange (GtkTextLayout     *layout,
       if (line_data)
         *height = line_data->height;
       else
-        *height = 0;
+        *height = layout->estimated_line_height;
     }
 }
 
@@ -4122,6 +4205,7 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
   GtkTextLine *last_line;
   GtkCssNode *node;
   GtkCssStyle *style;
+  float block_cursor_alpha;
 
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
   g_return_if_fail (layout->default_style != NULL);
@@ -4188,6 +4272,11 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
       draw_selection_text = FALSE;
     }
 
+  /* The block cursor is drawn as part of the line, this is
+   * what it looks like in this frame.
+   */
+  block_cursor_alpha = gtk_widget_has_focus (widget) ? cursor_alpha : 0;
+
   gtk_text_layout_wrap_loop_start (layout);
 
   for (GtkTextLine *line = first_line;
@@ -4242,7 +4331,11 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
 
           if (line_display->node != NULL)
             {
-              if (line_display->has_block_cursor && gtk_widget_has_focus (widget))
+              /* Keep the node around as long as the block cursor in it looks
+               * the same, e.g. while the cursor blink is not fading.
+               */
+              if (line_display->has_block_cursor &&
+                  line_display->node_cursor_alpha != block_cursor_alpha)
                 g_clear_pointer (&line_display->node, gsk_render_node_unref);
 
               if (selection_style_changed &&
@@ -4264,6 +4357,7 @@ gtk_text_layout_snapshot (GtkTextLayout      *layout,
                            draw_selection_text,
                            cursor_alpha);
               line_display->node = gtk_snapshot_pop_collect (snapshot);
+              line_display->node_cursor_alpha = block_cursor_alpha;
             }
 
           if (line_display->node != NULL)
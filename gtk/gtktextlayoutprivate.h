@@ -115,6 +115,9 @@ struct _GtkTextLayout
   int left_padding;
   int right_padding;
 
+  /* height assumed for lines that have not been laid out yet */
+  int estimated_line_height;
+
   GtkTextBuffer *buffer;
 
   /* Default style used if no tags override it */
@@ -178,6 +181,7 @@ struct _GtkTextLineDisplay
   PangoLayout *layout;
 
   GskRenderNode *node;
+  float node_cursor_alpha;      /* Alpha of the block cursor in node */
 
   GArray *cursors;      /* indexes of cursors in the PangoLayout, and mark names */
 
@@ -187,6 +191,9 @@ struct _GtkTextLineDisplay
   /* GQueue link for use in MRU to help cull cache */
   GList          mru_link;
 
+  /* Estimated memory use, as accounted for by the cache */
+  gsize          cache_size;
+
   GtkTextDirection direction;
 
   int width;                   /* Width of layout */
@@ -25,10 +25,26 @@
 #include "gtktextlinedisplaycacheprivate.h"
 #include "gtkprivate.h"
 
+#include "gdk/gdkprofilerprivate.h"
+
 #define DEFAULT_MRU_SIZE         250
 #define BLOW_CACHE_TIMEOUT_SEC   20
 #define DEBUG_LINE_DISPLAY_CACHE 0
 
+/* Displays beyond the MRU size are kept as long as the cached
+ * displays of all text views together stay below this many bytes.
+ * The MRU size is derived from the visible range, so this mostly
+ * helps when scrolling back and forth over lines that were just
+ * shown. The budget is shared so that applications with many text
+ * views don't keep that much for each of them.
+ */
+#define BYTE_BUDGET              (8 * 1024 * 1024)
+
+/* Rough memory cost of a laid out character, for the PangoLayout
+ * with its glyph strings and log attrs.
+ */
+#define BYTES_PER_CHAR           48
+
 struct _GtkTextLineDisplayCache
 {
   GSequence   *sorted_by_line;
@@ -37,6 +53,12 @@ struct _GtkTextLineDisplayCache
   GQueue       mru;
   GSource     *evict_source;
   guint        mru_size;
+  gsize        n_bytes;
+
+  /* Since the last frame, for the profiler */
+  guint        n_hits;
+  guint        n_misses;
+  guint        n_evictions;
 
 #if DEBUG_LINE_DISPLAY_CACHE
   guint       log_source;
@@ -53,6 +75,14 @@ struct _GtkTextLineDisplayCache
 static GQueue purge_in_idle;
 static guint purge_in_idle_source;
 
+/* Bytes used by the displays of all caches */
+static gsize total_bytes;
+
+static guint hits_counter;
+static guint misses_counter;
+static guint evictions_counter;
+static guint bytes_counter;
+
 #if DEBUG_LINE_DISPLAY_CACHE
 # define STAT_ADD(val,n) ((val) += n)
 # define STAT_INC(val)   STAT_ADD(val,1)
@@ -109,6 +139,40 @@ gtk_text_line_display_cache_free (GtkTextLineDisplayCache *cache)
   g_free (cache);
 }
 
+static gsize
+gtk_text_line_display_get_cache_size (GtkTextLineDisplay *display)
+{
+  gsize size = sizeof (GtkTextLineDisplay);
+
+  if (display->layout != NULL)
+    size += (gsize) pango_layout_get_character_count (display->layout) * BYTES_PER_CHAR;
+
+  return size;
+}
+
+/*
+ * gtk_text_line_display_cache_trim:
+ * @cache: a GtkTextLineDisplayCache
+ * @byte_budget: how many bytes the displays of all caches may use
+ *
+ * Evicts the least recently used displays of @cache until there are
+ * no more than the MRU size of them, or the displays of all caches
+ * together fit into @byte_budget.
+ */
+static void
+gtk_text_line_display_cache_trim (GtkTextLineDisplayCache *cache,
+                                  gsize                    byte_budget)
+{
+  while (cache->mru.length > cache->mru_size &&
+         total_bytes > byte_budget)
+    {
+      GtkTextLineDisplay *display = g_queue_peek_tail (&cache->mru);
+
+      gtk_text_line_display_cache_invalidate_display (cache, display, FALSE);
+      cache->n_evictions++;
+    }
+}
+
 static gboolean
 gtk_text_line_display_cache_blow_cb (gpointer data)
 {
@@ -122,7 +186,10 @@ gtk_text_line_display_cache_blow_cb (gpointer data)
 
   cache->evict_source = NULL;
 
-  gtk_text_line_display_cache_invalidate (cache);
+  /* Nothing was drawn for a while, give back what we kept
+   * beyond the visible range, but keep what is on screen.
+   */
+  gtk_text_line_display_cache_trim (cache, 0);
 
   return G_SOURCE_REMOVE;
 }
@@ -132,6 +199,26 @@ gtk_text_line_display_cache_delay_eviction (GtkTextLineDisplayCache *cache)
 {
   g_assert (cache != NULL);
 
+  /* This is called once per snapshot */
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      if (hits_counter == 0)
+        {
+          hits_counter = gdk_profiler_define_int_counter ("line-display-hits", "Line display cache hits");
+          misses_counter = gdk_profiler_define_int_counter ("line-display-misses", "Line display cache misses");
+          evictions_counter = gdk_profiler_define_int_counter ("line-display-evictions", "Line display cache evictions");
+          bytes_counter = gdk_profiler_define_int_counter ("line-display-bytes", "Line display caches size in bytes");
+        }
+
+      gdk_profiler_set_int_counter (hits_counter, cache->n_hits);
+      gdk_profiler_set_int_counter (misses_counter, cache->n_misses);
+      gdk_profiler_set_int_counter (evictions_counter, cache->n_evictions);
+      gdk_profiler_set_int_counter (bytes_counter, total_bytes);
+    }
+  cache->n_hits = 0;
+  cache->n_misses = 0;
+  cache->n_evictions = 0;
+
   if (cache->evict_source != NULL)
     {
       gint64 deadline;
@@ -206,14 +293,12 @@ gtk_text_line_display_cache_take_display (GtkTextLineDisplayCache *cache,
                               layout);
   g_hash_table_insert (cache->line_to_display, display->line, display);
   g_queue_push_head_link (&cache->mru, &display->mru_link);
+  display->cache_size = gtk_text_line_display_get_cache_size (display);
+  cache->n_bytes += display->cache_size;
+  total_bytes += display->cache_size;
 
   /* Cull the cache if we're at capacity */
-  while (cache->mru.length > cache->mru_size)
-    {
-      display = g_queue_peek_tail (&cache->mru);
-
-      gtk_text_line_display_cache_invalidate_display (cache, display, FALSE);
-    }
+  gtk_text_line_display_cache_trim (cache, BYTE_BUDGET);
 }
 
 static gboolean
@@ -281,6 +366,9 @@ gtk_text_line_display_cache_invalidate_display (GtkTextLineDisplayCache *cache,
 
       if (iter != NULL)
         {
+          cache->n_bytes -= display->cache_size;
+          total_bytes -= display->cache_size;
+
           g_sequence_remove (iter);
 
           g_queue_push_head_link (&purge_in_idle, &display->mru_link);
@@ -342,6 +430,7 @@ gtk_text_line_display_cache_get (GtkTextLineDisplayCache *cache,
       if (size_only || !display->size_only)
         {
           STAT_INC (cache->hits);
+          cache->n_hits++;
 
           if (!size_only && display->line == cache->cursor_line)
             gtk_text_layout_update_display_cursors (layout, display->line, display);
@@ -364,6 +453,7 @@ gtk_text_line_display_cache_get (GtkTextLineDisplayCache *cache,
     }
 
   STAT_INC (cache->misses);
+  cache->n_misses++;
 
   g_assert (!g_hash_table_lookup (cache->line_to_display, line));
 
@@ -409,6 +499,7 @@ gtk_text_line_display_cache_invalidate (GtkTextLineDisplayCache *cache)
   g_assert (g_hash_table_size (cache->line_to_display) == 0);
   g_assert (g_sequence_get_length (cache->sorted_by_line) == 0);
   g_assert (cache->mru.length == 0);
+  g_assert (cache->n_bytes == 0);
 }
 
 void
@@ -794,8 +885,6 @@ void
 gtk_text_line_display_cache_set_mru_size (GtkTextLineDisplayCache *cache,
                                           guint                    mru_size)
 {
-  GtkTextLineDisplay *display;
-
   g_assert (cache != NULL);
 
   if (mru_size == 0)
@@ -805,11 +894,6 @@ gtk_text_line_display_cache_set_mru_size (GtkTextLineDisplayCache *cache,
     {
       cache->mru_size = mru_size;
 
-      while (cache->mru.length > cache->mru_size)
-        {
-          display = g_queue_peek_tail (&cache->mru);
-
-          gtk_text_line_display_cache_invalidate_display (cache, display, FALSE);
-        }
+      gtk_text_line_display_cache_trim (cache, BYTE_BUDGET);
     }
 }
@@ -157,6 +157,26 @@ gtk_text_line_segment_split (const GtkTextIter *iter)
 #define TSEG_SIZE ((unsigned) (G_STRUCT_OFFSET (GtkTextLineSegment, body) \
         + sizeof (GtkTextToggleBody)))
 
+/* Returns the number of bytes allocated for the segment */
+gsize
+gtk_text_line_segment_get_size (GtkTextLineSegment *seg)
+{
+  if (seg->type == &gtk_text_char_type)
+    return CSEG_SIZE (seg->byte_count);
+  else if (seg->type == &gtk_text_toggle_on_type ||
+           seg->type == &gtk_text_toggle_off_type)
+    return TSEG_SIZE;
+  else if (seg->type == &gtk_text_left_mark_type ||
+           seg->type == &gtk_text_right_mark_type)
+    return G_STRUCT_OFFSET (GtkTextLineSegment, body) + sizeof (GtkTextMarkBody);
+  else if (seg->type == &gtk_text_paintable_type)
+    return G_STRUCT_OFFSET (GtkTextLineSegment, body) + sizeof (GtkTextPaintable);
+  else if (seg->type == &gtk_text_child_type)
+    return G_STRUCT_OFFSET (GtkTextLineSegment, body) + sizeof (GtkTextChildBody);
+  else
+    return sizeof (GtkTextLineSegment);
+}
+
 /*
  * Type functions
  */
@@ -150,6 +150,7 @@ struct _GtkTextLineSegment {
 
 
 GtkTextLineSegment  *gtk_text_line_segment_split (const GtkTextIter *iter);
+gsize                gtk_text_line_segment_get_size (GtkTextLineSegment *seg);
 
 GtkTextLineSegment *_gtk_char_segment_new                  (const char     *text,
                                                             guint           len);
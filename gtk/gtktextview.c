@@ -5004,15 +5004,27 @@ first_validate_callback (gpointer data)
   return FALSE;
 }
 
+/* How long to validate offscreen lines before returning to the main loop */
+#define INCREMENTAL_VALIDATE_TIME_SLICE (8 * G_TIME_SPAN_MILLISECOND)
+
 static gboolean
 incremental_validate_callback (gpointer data)
 {
   GtkTextView *text_view = data;
   gboolean result = TRUE;
+  gint64 end_time;
 
   DV(g_print(G_STRLOC"\n"));
 
-  gtk_text_layout_validate (text_view->priv->layout, 2000);
+  /* Validating a fixed number of pixels per idle makes huge buffers take
+   * many thousands of main loop iterations, each of them updating the
+   * adjustments. Keep validating for a time slice instead.
+   */
+  end_time = g_get_monotonic_time () + INCREMENTAL_VALIDATE_TIME_SLICE;
+  do
+    gtk_text_layout_validate (text_view->priv->layout, 2000);
+  while (!gtk_text_layout_is_valid (text_view->priv->layout) &&
+         g_get_monotonic_time () < end_time);
 
   gtk_text_view_update_adjustments (text_view);
 
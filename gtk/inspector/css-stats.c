@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2024 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include <glib/gi18n-lib.h>
+
+#include <string.h>
+
+#include "css-stats.h"
+
+#include "gtkbinlayout.h"
+#include "gtkbox.h"
+#include "gtkbutton.h"
+#include "gtkcssimagecacheprivate.h"
+#include "gtkcssnodeprivate.h"
+#include "gtklabel.h"
+#include "gtklistbox.h"
+
+/* How many triggers to show */
+#define MAX_TRIGGERS 100
+
+struct _GtkInspectorCssStats
+{
+  GtkWidget parent;
+
+  GtkWidget *swin;
+  GtkWidget *counters;
+  GtkWidget *triggers;
+
+  GtkWidget *validations;
+  GtkWidget *invalidated_nodes;
+  GtkWidget *created_styles;
+  GtkWidget *advanced_styles;
+  GtkWidget *cache_hits;
+  GtkWidget *cache_misses;
+  GtkWidget *cached_images;
+  GtkWidget *cached_image_size;
+
+  /* name and value labels of the rows in triggers, alternating */
+  GPtrArray *trigger_labels;
+
+  GtkCssNodeStats last_stats;
+  GtkCssImageCacheStats last_image_stats;
+
+  guint update_source_id;
+};
+
+typedef struct _GtkInspectorCssStatsClass
+{
+  GtkWidgetClass parent_class;
+} GtkInspectorCssStatsClass;
+
+G_DEFINE_TYPE (GtkInspectorCssStats, gtk_inspector_css_stats, GTK_TYPE_WIDGET)
+
+static GtkWidget *
+add_row (GtkListBox  *list,
+         const char  *name,
+         const char  *value,
+         GtkWidget  **out_name_label)
+{
+  GtkWidget *row, *box, *label, *value_label;
+
+  box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 40);
+
+  label = gtk_label_new (name);
+  gtk_widget_set_halign (label, GTK_ALIGN_START);
+  gtk_widget_set_valign (label, GTK_ALIGN_BASELINE_FILL);
+  gtk_label_set_xalign (GTK_LABEL (label), 0.0);
+  gtk_label_set_ellipsize (GTK_LABEL (label), PANGO_ELLIPSIZE_END);
+  gtk_label_set_selectable (GTK_LABEL (label), TRUE);
+  gtk_widget_set_hexpand (label, TRUE);
+  gtk_box_append (GTK_BOX (box), label);
+
+  value_label = gtk_label_new (value);
+  gtk_widget_set_halign (value_label, GTK_ALIGN_END);
+  gtk_widget_set_valign (value_label, GTK_ALIGN_BASELINE_FILL);
+  gtk_box_append (GTK_BOX (box), value_label);
+
+  row = gtk_list_box_row_new ();
+  gtk_list_box_row_set_child (GTK_LIST_BOX_ROW (row), box);
+  gtk_list_box_row_set_activatable (GTK_LIST_BOX_ROW (row), FALSE);
+  gtk_list_box_insert (list, row, -1);
+
+  if (out_name_label)
+    *out_name_label = label;
+
+  return value_label;
+}
+
+static void
+set_counter (GtkWidget *label,
+             guint64    value)
+{
+  char *text;
+
+  text = g_strdup_printf ("%" G_GUINT64_FORMAT, value);
+  gtk_label_set_label (GTK_LABEL (label), text);
+  g_free (text);
+}
+
+/* Adding and removing rows restyles them, which would show up in the
+ * stats, so the rows are reused and only changed labels are updated.
+ */
+static void
+update_stats (GtkInspectorCssStats *self,
+              gboolean              force)
+{
+  GtkCssNodeStats stats;
+  GtkCssImageCacheStats image_stats;
+  GPtrArray *triggers;
+  char *size;
+  guint i, n_rows;
+
+  gtk_css_node_get_stats (&stats);
+  gtk_css_image_cache_get_stats (&image_stats);
+
+  if (!force &&
+      memcmp (&stats, &self->last_stats, sizeof (GtkCssNodeStats)) == 0 &&
+      image_stats.n_textures == self->last_image_stats.n_textures &&
+      image_stats.texture_size == self->last_image_stats.texture_size)
+    return;
+
+  self->last_stats = stats;
+  self->last_image_stats = image_stats;
+
+  set_counter (self->validations, stats.validations);
+  set_counter (self->invalidated_nodes, stats.invalidated_nodes);
+  set_counter (self->created_styles, stats.created_styles);
+  set_counter (self->advanced_styles, stats.advanced_styles);
+  set_counter (self->cache_hits, stats.cache_hits);
+  set_counter (self->cache_misses, stats.cache_misses);
+
+  set_counter (self->cached_images, image_stats.n_textures);
+  size = g_format_size (image_stats.texture_size);
+  gtk_label_set_label (GTK_LABEL (self->cached_image_size), size);
+  g_free (size);
+
+  triggers = gtk_css_node_get_trigger_stats ();
+  n_rows = MIN (triggers->len, MAX_TRIGGERS);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      GtkCssNodeTriggerStats *trigger = g_ptr_array_index (triggers, i);
+      char *value;
+
+      /* Translators: The first number is how often a style change
+       * happened, the second how many styles it caused to be computed */
+      value = g_strdup_printf (_("%u changes, %" G_GUINT64_FORMAT " restyles"),
+                               trigger->n_triggers, trigger->n_restyled);
+      if (2 * i < self->trigger_labels->len)
+        {
+          gtk_label_set_label (g_ptr_array_index (self->trigger_labels, 2 * i), trigger->description);
+          gtk_label_set_label (g_ptr_array_index (self->trigger_labels, 2 * i + 1), value);
+        }
+      else
+        {
+          GtkWidget *name_label, *value_label;
+
+          value_label = add_row (GTK_LIST_BOX (self->triggers), trigger->description, value, &name_label);
+          g_ptr_array_add (self->trigger_labels, name_label);
+          g_ptr_array_add (self->trigger_labels, value_label);
+        }
+      g_free (value);
+    }
+  g_ptr_array_unref (triggers);
+
+  while (self->trigger_labels->len > 2 * n_rows)
+    {
+      GtkWidget *row;
+
+      row = gtk_widget_get_ancestor (g_ptr_array_index (self->trigger_labels, self->trigger_labels->len - 1),
+                                     GTK_TYPE_LIST_BOX_ROW);
+      gtk_list_box_remove (GTK_LIST_BOX (self->triggers), row);
+      g_ptr_array_set_size (self->trigger_labels, self->trigger_labels->len - 2);
+    }
+}
+
+static gboolean
+update_timeout (gpointer data)
+{
+  update_stats (GTK_INSPECTOR_CSS_STATS (data), FALSE);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+reset_clicked (GtkButton            *button,
+               GtkInspectorCssStats *self)
+{
+  gtk_css_node_reset_stats ();
+  update_stats (self, TRUE);
+}
+
+static void
+gtk_inspector_css_stats_init (GtkInspectorCssStats *self)
+{
+  GtkListBox *counters;
+
+  gtk_widget_init_template (GTK_WIDGET (self));
+
+  self->trigger_labels = g_ptr_array_new ();
+
+  counters = GTK_LIST_BOX (self->counters);
+  self->validations = add_row (counters, _("Validations"), "0", NULL);
+  self->invalidated_nodes = add_row (counters, _("Invalidated nodes"), "0", NULL);
+  self->created_styles = add_row (counters, _("Computed styles"), "0", NULL);
+  self->advanced_styles = add_row (counters, _("Animated styles"), "0", NULL);
+  self->cache_hits = add_row (counters, _("Style cache hits"), "0", NULL);
+  self->cache_misses = add_row (counters, _("Style cache misses"), "0", NULL);
+  self->cached_images = add_row (counters, _("Cached images"), "0", NULL);
+  self->cached_image_size = add_row (counters, _("Cached image memory"), "0", NULL);
+}
+
+/* Recording the triggers costs a bit, so only do it while the page is shown */
+static void
+gtk_inspector_css_stats_map (GtkWidget *widget)
+{
+  GtkInspectorCssStats *self = GTK_INSPECTOR_CSS_STATS (widget);
+
+  GTK_WIDGET_CLASS (gtk_inspector_css_stats_parent_class)->map (widget);
+
+  gtk_css_node_set_record_stats (TRUE);
+  update_stats (self, TRUE);
+  self->update_source_id = g_timeout_add_seconds (1, update_timeout, self);
+}
+
+static void
+gtk_inspector_css_stats_unmap (GtkWidget *widget)
+{
+  GtkInspectorCssStats *self = GTK_INSPECTOR_CSS_STATS (widget);
+
+  g_clear_handle_id (&self->update_source_id, g_source_remove);
+  gtk_css_node_set_record_stats (FALSE);
+
+  GTK_WIDGET_CLASS (gtk_inspector_css_stats_parent_class)->unmap (widget);
+}
+
+static void
+gtk_inspector_css_stats_dispose (GObject *object)
+{
+  GtkInspectorCssStats *self = GTK_INSPECTOR_CSS_STATS (object);
+
+  g_clear_handle_id (&self->update_source_id, g_source_remove);
+  g_clear_pointer (&self->trigger_labels, g_ptr_array_unref);
+
+  gtk_widget_dispose_template (GTK_WIDGET (self), GTK_TYPE_INSPECTOR_CSS_STATS);
+
+  G_OBJECT_CLASS (gtk_inspector_css_stats_parent_class)->dispose (object);
+}
+
+static void
+gtk_inspector_css_stats_class_init (GtkInspectorCssStatsClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+  object_class->dispose = gtk_inspector_css_stats_dispose;
+
+  widget_class->map = gtk_inspector_css_stats_map;
+  widget_class->unmap = gtk_inspector_css_stats_unmap;
+
+  gtk_widget_class_set_template_from_resource (widget_class, "/org/gtk/libgtk/inspector/css-stats.ui");
+  gtk_widget_class_bind_template_child (widget_class, GtkInspectorCssStats, swin);
+  gtk_widget_class_bind_template_child (widget_class, GtkInspectorCssStats, counters);
+  gtk_widget_class_bind_template_child (widget_class, GtkInspectorCssStats, triggers);
+
+  gtk_widget_class_bind_template_callback (widget_class, reset_clicked);
+
+  gtk_widget_class_set_layout_manager_type (widget_class, GTK_TYPE_BIN_LAYOUT);
+}
+
+// vim: set et sw=2 ts=2:
@@ -31,6 +31,7 @@
 #include "controllers.h"
 #include "css-editor.h"
 #include "css-node-tree.h"
+#include "css-stats.h"
 #include "general.h"
 #include "graphdata.h"
 #include "list-data.h"
@@ -74,6 +75,7 @@ gtk_inspector_init (void)
   g_type_ensure (GTK_TYPE_INSPECTOR_CONTROLLERS);
   g_type_ensure (GTK_TYPE_INSPECTOR_CSS_EDITOR);
   g_type_ensure (GTK_TYPE_INSPECTOR_CSS_NODE_TREE);
+  g_type_ensure (GTK_TYPE_INSPECTOR_CSS_STATS);
   g_type_ensure (GTK_TYPE_INSPECTOR_GENERAL);
   g_type_ensure (GTK_TYPE_INSPECTOR_LIST_DATA);
   g_type_ensure (GTK_TYPE_INSPECTOR_LOGS);
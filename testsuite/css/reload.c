@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2026 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include "gtk/gtkwidgetprivate.h"
+#include "gtk/gtkcssnodeprivate.h"
+
+static void
+assert_color (GtkWidget  *widget,
+              const char *expected)
+{
+  GdkRGBA color, expected_color;
+
+  gdk_rgba_parse (&expected_color, expected);
+  gtk_widget_get_color (widget, &color);
+  g_assert_true (gdk_rgba_equal (&color, &expected_color));
+}
+
+static GtkCssStyle *
+get_style (GtkWidget *widget)
+{
+  return gtk_css_node_get_style (gtk_widget_get_css_node (widget));
+}
+
+static GtkCssProvider *
+add_provider (const char *css)
+{
+  GtkCssProvider *p;
+
+  p = gtk_css_provider_new ();
+  gtk_css_provider_load_from_string (p, css);
+  gtk_style_context_add_provider_for_display (gdk_display_get_default (),
+                                              GTK_STYLE_PROVIDER (p),
+                                              GTK_STYLE_PROVIDER_PRIORITY_USER + 1);
+
+  return p;
+}
+
+static void
+remove_provider (GtkCssProvider *p)
+{
+  gtk_style_context_remove_provider_for_display (gdk_display_get_default (),
+                                                 GTK_STYLE_PROVIDER (p));
+  g_object_unref (p);
+}
+
+static void
+test_changed_rules (void)
+{
+  GtkCssProvider *p;
+  GtkWidget *window, *box, *label, *button;
+  GtkCssStyle *label_style, *button_style;
+  GdkRGBA color;
+
+  p = add_provider ("label { color: red; } button { color: blue; }");
+
+  window = gtk_window_new ();
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  label = gtk_label_new ("label");
+  button = gtk_button_new ();
+  gtk_box_append (GTK_BOX (box), label);
+  gtk_box_append (GTK_BOX (box), button);
+  gtk_window_set_child (GTK_WINDOW (window), box);
+  gtk_widget_realize (window);
+
+  assert_color (label, "red");
+  assert_color (button, "blue");
+
+  /* Reloading identical CSS does not restyle anything */
+  label_style = get_style (label);
+  button_style = get_style (button);
+  gtk_css_provider_load_from_string (p, "label { color: red; } button { color: blue; }");
+  g_assert_true (get_style (label) == label_style);
+  g_assert_true (get_style (button) == button_style);
+
+  /* Only nodes matched by a changed rule are restyled */
+  gtk_css_provider_load_from_string (p, "label { color: lime; } button { color: blue; }");
+  g_assert_true (get_style (label) != label_style);
+  g_assert_true (get_style (button) == button_style);
+  assert_color (label, "lime");
+  assert_color (button, "blue");
+
+  /* A later reload only restyles the nodes its own changes affect */
+  label_style = get_style (label);
+  gtk_css_provider_load_from_string (p, "label { color: lime; } button { color: white; }");
+  g_assert_true (get_style (label) == label_style);
+  assert_color (button, "white");
+  gtk_css_provider_load_from_string (p, "label { color: lime; } button { color: blue; }");
+  assert_color (button, "blue");
+
+  /* Rule order matters for rules with equal specificity */
+  gtk_css_provider_load_from_string (p, "label { color: lime; } button { color: blue; } .both { color: red; } .both { color: yellow; }");
+  gtk_widget_add_css_class (label, "both");
+  assert_color (label, "yellow");
+  gtk_css_provider_load_from_string (p, "label { color: lime; } button { color: blue; } .both { color: yellow; } .both { color: red; }");
+  assert_color (label, "red");
+  assert_color (button, "blue");
+
+  gtk_css_provider_load_from_string (p, "label { color: lime; }");
+  assert_color (label, "lime");
+  gtk_widget_get_color (button, &color);
+  g_assert_false (gdk_rgba_equal (&color, &(GdkRGBA) { 0, 0, 1, 1 }));
+
+  remove_provider (p);
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+/* Reloading drops images from the cache, so styles using them
+ * must be recreated even if the CSS is the same.
+ */
+static void
+test_image_files (void)
+{
+  static const guchar pixel[4] = { 255, 0, 0, 255 };
+  GtkCssProvider *p;
+  GtkWidget *window, *label;
+  GtkCssStyle *label_style;
+  GdkTexture *texture;
+  GBytes *bytes;
+  char *path, *uri, *css;
+
+  bytes = g_bytes_new_static (pixel, sizeof (pixel));
+  texture = gdk_memory_texture_new (1, 1, GDK_MEMORY_R8G8B8A8, bytes, 4);
+  path = g_build_filename (g_get_tmp_dir (), "gtk-css-reload-test.png", NULL);
+  g_assert_true (gdk_texture_save_to_png (texture, path));
+  uri = g_filename_to_uri (path, NULL, NULL);
+  css = g_strdup_printf ("label { background-image: url('%s'); }", uri);
+
+  p = add_provider (css);
+
+  window = gtk_window_new ();
+  label = gtk_label_new ("label");
+  gtk_window_set_child (GTK_WINDOW (window), label);
+  gtk_widget_realize (window);
+
+  label_style = g_object_ref (get_style (label));
+  gtk_css_provider_load_from_string (p, css);
+  g_assert_true (get_style (label) != label_style);
+  g_object_unref (label_style);
+
+  remove_provider (p);
+  gtk_window_destroy (GTK_WINDOW (window));
+
+  g_remove (path);
+  g_free (css);
+  g_free (uri);
+  g_free (path);
+  g_object_unref (texture);
+  g_bytes_unref (bytes);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/css/reload/changed-rules", test_changed_rules);
+  g_test_add_func ("/css/reload/image-files", test_image_files);
+
+  return g_test_run ();
+}
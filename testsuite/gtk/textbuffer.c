@@ -1921,6 +1921,74 @@ test_serialize_wrap_mode (void)
   g_assert_finalize_object (buffer);
 }
 
+typedef struct {
+  int line;
+  int line_offset;
+  int line_index;
+  int offset;
+} IterPosition;
+
+static void
+record_insert_end (GtkTextBuffer *buffer,
+                   GtkTextIter   *location,
+                   const char    *text,
+                   int            len,
+                   IterPosition  *pos)
+{
+  pos->line = gtk_text_iter_get_line (location);
+  pos->line_offset = gtk_text_iter_get_line_offset (location);
+  pos->line_index = gtk_text_iter_get_line_index (location);
+  pos->offset = gtk_text_iter_get_offset (location);
+}
+
+/* After the default handler, the location points at the end of the
+ * inserted text. The btree computes that from the insertion instead
+ * of walking over the text, so check it for multi-line text with
+ * multibyte characters and all kinds of line separators.
+ */
+static void
+test_insert_end_iter (void)
+{
+  struct {
+    const char *initial;
+    int offset;
+    const char *text;
+    IterPosition end;
+  } tests[] = {
+    { "a\xc3\xa9", 1, "\xc3\xb1x", { 0, 3, 4, 3 } },
+    { "a\xc3\xa9\nb\xc3\xbc", 1, "\xc3\xb1x\ny\xc3\xa9\r\nz\xe2\x82\xac", { 2, 2, 4, 10 } },
+    { "a\xc3\xa9\nb\xc3\xbc", 4, "\xc3\xb1\n", { 2, 0, 0, 6 } },
+    { "", 0, "\xc3\xa9\xe2\x80\xa9\xe2\x82\xac\r\xc3\xb1", { 2, 1, 2, 5 } },
+    { "xyz", 3, "1\n22\n333\n4444", { 3, 4, 4, 16 } },
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (tests); i++)
+    {
+      GtkTextBuffer *buffer;
+      GtkTextIter iter;
+      IterPosition pos = { -1, -1, -1, -1 };
+
+      buffer = gtk_text_buffer_new (NULL);
+      gtk_text_buffer_set_text (buffer, tests[i].initial, -1);
+      g_signal_connect_after (buffer, "insert-text", G_CALLBACK (record_insert_end), &pos);
+
+      gtk_text_buffer_get_iter_at_offset (buffer, &iter, tests[i].offset);
+      gtk_text_buffer_insert (buffer, &iter, tests[i].text, -1);
+
+      g_assert_cmpint (pos.line, ==, tests[i].end.line);
+      g_assert_cmpint (pos.line_offset, ==, tests[i].end.line_offset);
+      g_assert_cmpint (pos.line_index, ==, tests[i].end.line_index);
+      g_assert_cmpint (pos.offset, ==, tests[i].end.offset);
+
+      /* The caller's iter is revalidated to the same place */
+      g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==, tests[i].end.offset);
+      g_assert_cmpint (gtk_text_iter_get_line_index (&iter), ==, tests[i].end.line_index);
+
+      g_object_unref (buffer);
+    }
+}
+
 int
 main (int argc, char** argv)
 {
@@ -1949,6 +2017,7 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Undo 4", test_undo4);
   g_test_add_func ("/TextBuffer/Undo 5", test_undo5);
   g_test_add_func ("/TextBuffer/Serialize wrap-mode", test_serialize_wrap_mode);
+  g_test_add_func ("/TextBuffer/Insert end iter", test_insert_end_iter);
 
   return g_test_run();
 }
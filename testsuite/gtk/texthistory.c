@@ -664,6 +664,43 @@ test_issue_5777 (void)
   run_test (commands, G_N_ELEMENTS (commands), 4);
 }
 
+static void
+test_max_bytes (void)
+{
+  Text *text = text_new ();
+  gsize line_len = 0;
+  guint n_undo = 0;
+
+  /* Each line ends in a newline so the inserts are not chained, and is
+   * long enough that the text is not stored inline in the action.
+   */
+  gtk_text_history_set_max_bytes (text->history, 4096);
+
+  for (guint i = 0; i < 100; i++)
+    {
+      char *str = g_strdup_printf ("line %03u is long enough to be on the heap\n", i);
+      Command cmd = { INSERT, text->buf->len, -1, str, NULL };
+
+      line_len = strlen (str);
+      command_insert (&cmd, text);
+      g_free (str);
+    }
+
+  g_assert_cmpuint (text->buf->len, ==, 100 * line_len);
+
+  while (text->can_undo)
+    {
+      gtk_text_history_undo (text->history);
+      n_undo++;
+    }
+
+  g_assert_cmpuint (n_undo, >, 0);
+  g_assert_cmpuint (n_undo, <, 100);
+  g_assert_cmpuint (text->buf->len, ==, (100 - n_undo) * line_len);
+
+  text_free (text);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -687,6 +724,7 @@ main (int   argc,
   g_test_add_func ("/Gtk/TextHistory/issue_4276", test_issue_4276);
   g_test_add_func ("/Gtk/TextHistory/issue_4575", test_issue_4575);
   g_test_add_func ("/Gtk/TextHistory/issue_5777", test_issue_5777);
+  g_test_add_func ("/Gtk/TextHistory/max_bytes", test_max_bytes);
 
   return g_test_run ();
 }
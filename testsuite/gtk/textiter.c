@@ -279,6 +279,61 @@ test_search_caseless (void)
   check_found_backward ("aa \303\200", "aa", flags, 0, 2, "aa");
 }
 
+static void
+check_search_all (const char         *haystack,
+                  const char         *needle,
+                  GtkTextSearchFlags  flags,
+                  int                 limit_offset,
+                  gsize               expected_matches)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter i, s, e, limit;
+  GtkTextIter *matches;
+  gsize n_iters, n;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, haystack, -1);
+
+  if (limit_offset >= 0)
+    gtk_text_buffer_get_iter_at_offset (buffer, &limit, limit_offset);
+
+  gtk_text_buffer_get_start_iter (buffer, &i);
+  matches = gtk_text_iter_forward_search_all (&i, needle, flags,
+                                              limit_offset >= 0 ? &limit : NULL,
+                                              &n_iters);
+  g_assert_cmpuint (n_iters, ==, 2 * expected_matches);
+
+  /* The matches are the same as for repeated forward searches */
+  for (n = 0; n < n_iters; n += 2)
+    {
+      g_assert_true (gtk_text_iter_forward_search (&i, needle, flags, &s, &e,
+                                                   limit_offset >= 0 ? &limit : NULL));
+      g_assert_true (gtk_text_iter_equal (&matches[n], &s));
+      g_assert_true (gtk_text_iter_equal (&matches[n + 1], &e));
+      i = e;
+    }
+  g_assert_false (gtk_text_iter_forward_search (&i, needle, flags, &s, &e,
+                                                limit_offset >= 0 ? &limit : NULL));
+
+  g_free (matches);
+  g_object_unref (buffer);
+}
+
+static void
+test_search_all (void)
+{
+  check_search_all ("This is some foo text", "foo", 0, -1, 1);
+  check_search_all ("This is some foo text", "Foo", 0, -1, 0);
+  check_search_all ("foo foo\nfoofoo\n\nfoo", "foo", 0, -1, 5);
+  check_search_all ("foo foo\nfoofoo\n\nfoo", "foo", 0, 12, 3);
+  check_search_all ("foo foo\nfoofoo\n\nfoo", "foo\n", 0, -1, 2);
+  check_search_all ("foo foo\nfoo\nfoo", "foo\nfoo", 0, -1, 1);
+  check_search_all ("\303\200 aa \303\200 aa", "aa", 0, -1, 2);
+  check_search_all ("Foo fOO\nfoo", "foo", GTK_TEXT_SEARCH_CASE_INSENSITIVE, -1, 3);
+  check_search_all ("\303\200 \303\240 a\314\200 b", "\303\240", GTK_TEXT_SEARCH_CASE_INSENSITIVE, -1, 3);
+  check_search_all ("\303\200 \303\240 a\314\200 b", "a\314\200 ", GTK_TEXT_SEARCH_CASE_INSENSITIVE, -1, 3);
+}
+
 static void
 test_forward_to_tag_toggle (void)
 {
@@ -841,6 +896,7 @@ main (int argc, char** argv)
   g_test_add_func ("/TextIter/Search Full Buffer", test_search_full_buffer);
   g_test_add_func ("/TextIter/Search", test_search);
   g_test_add_func ("/TextIter/Search Caseless", test_search_caseless);
+  g_test_add_func ("/TextIter/Search All", test_search_all);
   g_test_add_func ("/TextIter/Forward To Tag Toggle", test_forward_to_tag_toggle);
   g_test_add_func ("/TextIter/Forward To Line End", test_forward_to_line_end);
   g_test_add_func ("/TextIter/Word Boundaries", test_word_boundaries);
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 the GTK team
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+
+#define N_LINES 2000
+
+static GtkTextBuffer *
+create_buffer (void)
+{
+  GtkTextBuffer *buffer;
+  GString *str;
+  guint i;
+
+  str = g_string_new (NULL);
+  for (i = 0; i < N_LINES; i++)
+    g_string_append_printf (str, "line %u\n", i);
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, str->str, str->len);
+  g_string_free (str, TRUE);
+
+  return buffer;
+}
+
+static void
+get_line_yrange (GtkTextView *view,
+                 int          line,
+                 int         *y,
+                 int         *height)
+{
+  GtkTextIter iter;
+
+  gtk_text_buffer_get_iter_at_line (gtk_text_view_get_buffer (view), &iter, line);
+  gtk_text_view_get_line_yrange (view, &iter, y, height);
+}
+
+/* Lines that have not been laid out count with the estimated
+ * line height, both for their position and for finding them.
+ */
+static void
+test_estimated_heights (void)
+{
+  GtkTextBuffer *buffer;
+  GtkWidget *view;
+  GtkTextIter iter;
+  int y1, height1, y2, height2, line_top;
+
+  buffer = create_buffer ();
+  view = gtk_text_view_new_with_buffer (buffer);
+  g_object_ref_sink (view);
+
+  get_line_yrange (GTK_TEXT_VIEW (view), N_LINES / 2, &y1, &height1);
+  get_line_yrange (GTK_TEXT_VIEW (view), N_LINES - 1, &y2, &height2);
+
+  g_assert_cmpint (height1, >, 0);
+  g_assert_cmpint (height2, ==, height1);
+  g_assert_cmpint (y1, >=, height1 * (N_LINES / 2) / 2);
+  g_assert_cmpint (y2 - y1, ==, height1 * (N_LINES - 1 - N_LINES / 2));
+
+  gtk_text_view_get_line_at_y (GTK_TEXT_VIEW (view), &iter, y1 + height1 / 2, &line_top);
+  g_assert_cmpint (gtk_text_iter_get_line (&iter), ==, N_LINES / 2);
+  g_assert_cmpint (line_top, ==, y1);
+
+  gtk_text_view_get_line_at_y (GTK_TEXT_VIEW (view), &iter, y2 - 1, &line_top);
+  g_assert_cmpint (gtk_text_iter_get_line (&iter), ==, N_LINES - 2);
+  g_assert_cmpint (line_top, ==, y2 - height1);
+
+  g_object_unref (view);
+  g_object_unref (buffer);
+}
+
+static void
+test_scroll_to_estimated_line (void)
+{
+  GtkTextBuffer *buffer;
+  GtkWidget *window, *sw, *view;
+  GtkAdjustment *vadj;
+  GtkTextIter iter;
+  int y, height, i;
+
+  buffer = create_buffer ();
+  view = gtk_text_view_new_with_buffer (buffer);
+  sw = gtk_scrolled_window_new ();
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (sw), view);
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 300, 300);
+  gtk_window_set_child (GTK_WINDOW (window), sw);
+  gtk_window_present (GTK_WINDOW (window));
+
+  for (i = 0; i < 1000 && gtk_widget_get_height (view) == 0; i++)
+    g_main_context_iteration (NULL, FALSE);
+  g_assert_cmpint (gtk_widget_get_height (view), >, 0);
+
+  /* The scrollable area covers the lines that are not laid out yet */
+  get_line_yrange (GTK_TEXT_VIEW (view), N_LINES - 1, &y, &height);
+  vadj = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (view));
+  g_assert_cmpfloat (gtk_adjustment_get_upper (vadj), >=, y);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, N_LINES * 3 / 4);
+  gtk_text_view_scroll_to_iter (GTK_TEXT_VIEW (view), &iter, 0, TRUE, 0, 0);
+
+  get_line_yrange (GTK_TEXT_VIEW (view), N_LINES * 3 / 4, &y, &height);
+  g_assert_cmpfloat_with_epsilon (gtk_adjustment_get_value (vadj), y, 1);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+  g_object_unref (buffer);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/textview/estimated-heights", test_estimated_heights);
+  g_test_add_func ("/textview/scroll-to-estimated-line", test_scroll_to_estimated_line);
+
+  return g_test_run ();
+}